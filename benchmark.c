@@ -1,47 +1,203 @@
+// Scheduler benchmark.
+//
+// benchmark [-n procs] [-c cpu%] [-b bursts] [-l ticks]
+//           [-d fixed|uniform|exp] [-p none|ramp|random|prio]
+//           [-k reps] [-s seed]
+//
+// Forks procs children (default 10).  Each runs the given number of
+// bursts (default 10); each burst is CPU with probability cpu%
+// (default 50) and otherwise a sleep, standing in for I/O.  Burst
+// lengths average -l ticks (default 5), and are all the same
+// (fixed), spread evenly up to twice that (uniform, the default), or
+// roughly exponential (exp).  -p sets the children's priorities with
+// set_priority(): ramp gives the first child the best priority and
+// the last the worst, random draws them at random, and a number
+// from 0 to 100 gives them all that priority.  The default leaves
+// them alone.
+//
+// The whole run is repeated reps times (default 1).  Each prints one
+// CSV line with the turnaround times of the children in ticks, their
+// mean run and wait times, and the throughput in children per 1000
+// ticks, so runs under different SCHEDULER= builds can be pasted
+// side by side.  The times come from waitstat(), as the kernel
+// recorded them: turnaround runs from fork to exit, however late
+// the parent gets round to reaping the child.
+
 #include "types.h"
+#include "stat.h"
 #include "user.h"
+#include "param.h"
+#include "sched.h"
+#include "pstat.h"
+
+#define MAXCHILD  (NPROC - 4)
+
+int nproc = 10, cpupct = 50, nburst = 10, len = 5, reps = 1;
+char *dist = "uniform", *prio = "none";
+uint seed = 1;
+int loops;  // spin() iterations per tick, measured while idle
 
-int number_of_processes = 10;
+int pids[MAXCHILD];
+int tat[MAXCHILD];     // Turnaround of each child, in ticks
 
-int main(int argc, char *argv[])
+uint
+rand(void)
 {
-  int j;
-  for (j = 0; j < number_of_processes; j++)
-  {
-    int pid = fork();
-    if (pid < 0)
-    {
-      printf(1, "Fork failed\n");
-      continue;
-    }
-    if (pid == 0)
-    {
-      volatile int i;
-      for (volatile int k = 0; k < number_of_processes; k++)
-      {
-        if (k <= j)
-        {
-          sleep(200); //io time
-        }
-        else
-        {
-          for (i = 0; i < 100000000; i++)
-          {
-            ; //cpu time
-          }
-        }
-      }
-    //   printf(1, "Process: %d Finished\n", j);
-      exit();
-    }
-    else{
-        ;
-    //   set_priority(100-(20+j),pid); // will only matter for PBS, comment it out if not implemented yet (better priorty for more IO intensive jobs)
+  seed = seed * 1103515245 + 12345;
+  return seed >> 16;
+}
+
+// Length of the next burst, in ticks.
+int
+burstlen(void)
+{
+  int n;
+
+  if(strcmp(dist, "fixed") == 0)
+    return len;
+  if(strcmp(dist, "exp") == 0){
+    for(n = 1; rand() % len != 0; n++)
+      ;
+    return n;
+  }
+  return 1 + rand() % (2 * len - 1);
+}
+
+void
+child(void)
+{
+  int i;
+
+  for(i = 0; i < nburst; i++){
+    if(rand() % 100 < cpupct)
+      spin(burstlen() * loops);
+    else
+      sleep(burstlen());
+  }
+  exit();
+}
+
+// The priority for child i, or -1 to leave it alone.
+int
+priority(int i)
+{
+  if(strcmp(prio, "none") == 0)
+    return -1;
+  if(strcmp(prio, "ramp") == 0)
+    return nproc > 1 ? 20 + 60 * i / (nproc - 1) : 60;
+  if(strcmp(prio, "random") == 0)
+    return rand() % 101;
+  return atoi(prio);
+}
+
+// Is s a -p argument that priority() understands?
+int
+validprio(char *s)
+{
+  char *t;
+
+  if(strcmp(s, "none") == 0 || strcmp(s, "ramp") == 0 ||
+     strcmp(s, "random") == 0)
+    return 1;
+  for(t = s; *t; t++)
+    if(*t < '0' || *t > '9')
+      return 0;
+  return t > s && t - s <= 3 && atoi(s) <= 100;
+}
+
+void
+sort(int *a, int n)
+{
+  int i, j, t;
+
+  for(i = 1; i < n; i++){
+    t = a[i];
+    for(j = i; j > 0 && a[j-1] > t; j--)
+      a[j] = a[j-1];
+    a[j] = t;
+  }
+}
+
+void
+run(int rep)
+{
+  struct proctime pt;
+  int i, n, p, sumrtime, sumwtime, sumtat;
+  uint start, elapsed;
+
+  start = uptime();
+  for(n = 0; n < nproc; n++){
+    seed += 7919;
+    if((pids[n] = fork()) < 0){
+      printf(2, "benchmark: fork failed\n");
+      break;
     }
+    if(pids[n] == 0)
+      child();
+    if((p = priority(n)) >= 0)
+      set_priority(p, pids[n]);
+  }
+
+  sumrtime = sumwtime = sumtat = 0;
+  for(i = 0; i < n; i++){
+    if(waitstat(&pt) < 0)
+      break;
+    // The kernel's wtime is exit minus creation less the rest.
+    tat[i] = pt.rtime + pt.wtime + pt.iotime;
+    sumtat += tat[i];
+    sumrtime += pt.rtime;
+    sumwtime += pt.wtime;
   }
-  for (j = 0; j < number_of_processes+5; j++)
-  {
-    wait();
+  elapsed = uptime() - start;
+  if(n == 0 || elapsed == 0)
+    elapsed = 1;
+  sort(tat, n);
+
+  printf(1, "%s,%d,%d,%d,%d,%d,%s,%s,%d,%d,%d,%d,%d,%d,%d\n",
+         schednames[setscheduler(-1)], rep, n, cpupct, nburst, len, dist, prio,
+         n ? sumtat / n : 0, n ? tat[n / 2] : 0, n ? tat[(n * 99) / 100] : 0,
+         n ? sumrtime / n : 0, n ? sumwtime / n : 0,
+         elapsed, n * 1000 / elapsed);
+}
+
+void
+usage(void)
+{
+  printf(2, "usage: benchmark [-n procs] [-c cpu%%] [-b bursts] [-l ticks]\n"
+            "                 [-d fixed|uniform|exp] [-p none|ramp|random|prio]\n"
+            "                 [-k reps] [-s seed]\n");
+  exit();
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i;
+
+  for(i = 1; i < argc; i += 2){
+    if(argv[i][0] != '-' || argv[i][1] == 0 || argv[i][2] != 0 || i + 1 >= argc)
+      usage();
+    switch(argv[i][1]){
+    case 'n': nproc = atoi(argv[i+1]); break;
+    case 'c': cpupct = atoi(argv[i+1]); break;
+    case 'b': nburst = atoi(argv[i+1]); break;
+    case 'l': len = atoi(argv[i+1]); break;
+    case 'd': dist = argv[i+1]; break;
+    case 'p': prio = argv[i+1]; break;
+    case 'k': reps = atoi(argv[i+1]); break;
+    case 's': seed = atoi(argv[i+1]); break;
+    default: usage();
+    }
   }
+  if(nproc < 1 || nproc > MAXCHILD || cpupct < 0 || cpupct > 100 ||
+     nburst < 1 || len < 1 || reps < 1 || !validprio(prio) ||
+     (strcmp(dist, "fixed") && strcmp(dist, "uniform") && strcmp(dist, "exp")))
+    usage();
+
+  loops = calibrate();
+  printf(1, "sched,rep,procs,cpu,bursts,len,dist,prio,"
+            "mean_tat,p50_tat,p99_tat,mean_rtime,mean_wtime,ticks,per_1000_ticks\n");
+  for(i = 0; i < reps; i++)
+    run(i);
   exit();
 }
@@ -1,6 +1,11 @@
 
 struct buf;
 struct context;
+struct cpustat;
+struct proctime;
+struct procinfo;
+struct schedlat;
+struct mlfqparam;
 struct file;
 struct inode;
 struct pipe;
@@ -80,6 +85,7 @@ extern volatile uint*    lapic;
 void            lapiceoi(void);
 void            lapicinit(void);
 void            lapicstartap(uchar, uint);
+void            lapicipi(int, int);
 void            microdelay(int);
 
 // log.c
@@ -122,8 +128,39 @@ int             wait(void);
 void            wakeup(void*);
 void            yield(void);
 int             waitx(int*, int*);
+int             waitstat(struct proctime*);
+int             getpinfo(struct procinfo*, int);
 int             getps(void); 
 int             set_priority(int, int);
+int             settickets(int, int);
+int             setaffinity(int, uint);
+int             setrt(int, int);
+int             clone(void(*)(void*, void*), void*, void*, void*);
+int             join(void**);
+void            execvm(pde_t*);
+int             futex_wait(int*, int);
+void            sleeplockwait(struct sleeplock*);
+void            sleeplockrelease(struct sleeplock*);
+int             futex_wake(int*, int);
+int             wakestat(int*, int*);
+
+// sched.c
+void            rqinit(void);
+void            rqenqueue(struct proc*);
+struct proc*    rqpick(int);
+void            rqclaim(struct proc*, int);
+int             rqresched(void);
+void            rqpreempt(int);
+void            rqidle(int);
+void            rqtimer(int);
+void            rqlatency(int, uint64);
+int             schedtick(struct proc*);
+int             getscheduler(void);
+int             setscheduler(int);
+int             setmlfq(struct mlfqparam*, struct mlfqparam*);
+char*           schedname(int);
+int             getcpustat(struct cpustat*, int);
+int             getschedlat(struct schedlat*, int, int);
 
 // swtch.S
 void            swtch(struct context**, struct context*);
@@ -169,6 +206,11 @@ extern uint     ticks;
 void            tvinit(void);
 extern struct spinlock tickslock;
 
+// tsc.c
+extern uint     tscmhz;
+void            tscinit(void);
+uint64          cycles2us(uint64);
+
 // uart.c
 void            uartinit(void);
 void            uartintr(void);
@@ -0,0 +1,78 @@
+// Fork throughput benchmark, derived from forktest.
+//
+// Like forktest, first forks until the process table is full, but
+// the children block on a pipe instead of exiting, so their slots
+// stay taken.  A few of them are then let go, and the benchmark
+// times a loop of fork() and wait() with the table almost full,
+// which is when searching the table for a free slot costs most.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define N       1000   // most holders to fork, as in forktest
+#define NFREE   4      // holders to let go before timing
+#define NFORKS  2000   // default number of timed forks
+
+int
+main(int argc, char *argv[])
+{
+  int nforks, nheld, i, pid, fd[2];
+  char c = 0;
+  uint start, end;
+
+  nforks = argc > 1 ? atoi(argv[1]) : NFORKS;
+  if(nforks <= 0){
+    printf(2, "usage: forkbench [forks]\n");
+    exit();
+  }
+  if(pipe(fd) < 0){
+    printf(2, "forkbench: pipe failed\n");
+    exit();
+  }
+
+  // Fill the table with holders that wait for one byte each.
+  for(nheld = 0; nheld < N; nheld++){
+    pid = fork();
+    if(pid < 0)
+      break;
+    if(pid == 0){
+      close(fd[1]);
+      read(fd[0], &c, 1);
+      exit();
+    }
+  }
+  if(nheld < NFREE){
+    printf(2, "forkbench: only %d processes forked\n", nheld);
+    exit();
+  }
+
+  // Let a few holders go to make room.
+  for(i = 0; i < NFREE; i++){
+    write(fd[1], &c, 1);
+    wait();
+  }
+  nheld -= NFREE;
+
+  start = uptime();
+  for(i = 0; i < nforks; i++){
+    pid = fork();
+    if(pid < 0){
+      printf(2, "forkbench: fork failed\n");
+      break;
+    }
+    if(pid == 0)
+      exit();
+    wait();
+  }
+  end = uptime();
+
+  // Release the rest.
+  close(fd[1]);
+  while(nheld-- > 0)
+    wait();
+
+  printf(1, "forkbench: %d forks in %d ticks, %d forks per 100 ticks\n",
+         i, end - start, (i * 100) / (end - start > 0 ? end - start : 1));
+  exit();
+}
@@ -0,0 +1,52 @@
+// Fork/exit storm benchmark.
+//
+// Repeatedly forks a batch of children that exit at once, then
+// reaps the whole batch.  While a batch is being reaped the process
+// table is full of zombies, so the cost of every wait() and exit()
+// shows up directly in the rate.  Build the kernel with
+// make NPROC=1024 and run a large batch to stress the table.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NBATCH   50     // default children per batch
+#define NROUNDS  20     // default number of batches
+
+int
+main(int argc, char *argv[])
+{
+  int nbatch, nrounds, i, j, n, pid;
+  uint start, end;
+
+  nbatch = argc > 1 ? atoi(argv[1]) : NBATCH;
+  nrounds = argc > 2 ? atoi(argv[2]) : NROUNDS;
+  if(nbatch <= 0 || nrounds <= 0){
+    printf(2, "usage: forkstorm [children] [rounds]\n");
+    exit();
+  }
+
+  n = 0;
+  start = uptime();
+  for(i = 0; i < nrounds; i++){
+    for(j = 0; j < nbatch; j++){
+      pid = fork();
+      if(pid < 0)
+        break;
+      if(pid == 0)
+        exit();
+    }
+    n += j;
+    for(; j > 0; j--){
+      if(wait() < 0){
+        printf(2, "forkstorm: wait stopped early\n");
+        exit();
+      }
+    }
+  }
+  end = uptime();
+
+  printf(1, "forkstorm: %d forks in %d ticks, %d forks per 100 ticks\n",
+         n, end - start, (n * 100) / (end - start > 0 ? end - start : 1));
+  exit();
+}
@@ -0,0 +1,176 @@
+// Lock contention benchmark for the futex-based primitives.
+//
+// futexbench [threads] [iters] has the given number of threads
+// (default 4) each add 1 to a shared counter iters times (default
+// 10000), first under the lock_t spinlock and then under a mutex_t,
+// and prints how long each took.  A waiting thread spins away the
+// rest of its time slice under the spinlock but sleeps in the kernel
+// under the mutex, which shows once there are more threads than
+// CPUs.  It then passes iters items from one producer to the other
+// threads through a small buffer guarded by a mutex and two
+// condition variables.  All threads start together at a barrier.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NTHREAD   4
+#define MAXTHREAD 16
+#define NITER     10000
+#define NBUF      8
+
+barrier_t start;
+lock_t spinlk;
+mutex_t mutex;
+int counter;
+int iters;
+
+// Bounded buffer for the producer/consumer phase.
+cond_t notempty, notfull;
+int buf[NBUF];
+int head, tail;
+int consumed;
+
+void
+spinworker(void *a1, void *a2)
+{
+  int i;
+
+  barrier_wait(&start);
+  for(i = 0; i < iters; i++){
+    lock_acquire(&spinlk);
+    counter++;
+    lock_release(&spinlk);
+  }
+  exit();
+}
+
+void
+mutexworker(void *a1, void *a2)
+{
+  int i;
+
+  barrier_wait(&start);
+  for(i = 0; i < iters; i++){
+    mutex_lock(&mutex);
+    counter++;
+    mutex_unlock(&mutex);
+  }
+  exit();
+}
+
+void
+put(int v)
+{
+  mutex_lock(&mutex);
+  while(tail - head == NBUF)
+    cond_wait(&notfull, &mutex);
+  buf[tail++ % NBUF] = v;
+  cond_signal(&notempty);
+  mutex_unlock(&mutex);
+}
+
+int
+get(void)
+{
+  int v;
+
+  mutex_lock(&mutex);
+  while(tail == head)
+    cond_wait(&notempty, &mutex);
+  v = buf[head++ % NBUF];
+  cond_signal(&notfull);
+  mutex_unlock(&mutex);
+  return v;
+}
+
+// The producer ends the stream with one -1 for each consumer.
+void
+producer(void *a1, void *a2)
+{
+  int n = (int)a1, i;
+
+  barrier_wait(&start);
+  for(i = 0; i < iters; i++)
+    put(i);
+  for(i = 0; i < n; i++)
+    put(-1);
+  exit();
+}
+
+void
+consumer(void *a1, void *a2)
+{
+  int n = 0;
+
+  barrier_wait(&start);
+  while(get() >= 0)
+    n++;
+  mutex_lock(&mutex);
+  consumed += n;
+  mutex_unlock(&mutex);
+  exit();
+}
+
+// Start n threads, the first running first and the rest running
+// rest, let them go together, and return the ticks until the last
+// one finished.
+int
+run(int n, void (*first)(void*, void*), void (*rest)(void*, void*))
+{
+  int i;
+  uint t;
+
+  barrier_init(&start, n + 1);
+  for(i = 0; i < n; i++){
+    if(thread_create(i == 0 ? first : rest, (void*)(n - 1), 0) < 0){
+      printf(2, "futexbench: thread_create failed\n");
+      exit();
+    }
+  }
+  barrier_wait(&start);
+  t = uptime();
+  for(i = 0; i < n; i++)
+    if(thread_join() < 0){
+      printf(2, "futexbench: thread_join failed\n");
+      exit();
+    }
+  return uptime() - t;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int n, t, ok;
+
+  n = argc > 1 ? atoi(argv[1]) : NTHREAD;
+  iters = argc > 2 ? atoi(argv[2]) : NITER;
+  if(n < 2 || n > MAXTHREAD || iters <= 0){
+    printf(2, "usage: futexbench [threads] [iters]\n");
+    exit();
+  }
+  ok = 1;
+
+  lock_init(&spinlk);
+  counter = 0;
+  t = run(n, spinworker, spinworker);
+  printf(1, "spinlock: %d threads x %d in %d ticks\n", n, iters, t);
+  ok &= counter == n * iters;
+
+  mutex_init(&mutex);
+  counter = 0;
+  t = run(n, mutexworker, mutexworker);
+  printf(1, "mutex:    %d threads x %d in %d ticks\n", n, iters, t);
+  ok &= counter == n * iters;
+
+  cond_init(&notempty);
+  cond_init(&notfull);
+  head = tail = consumed = 0;
+  t = run(n, producer, consumer);
+  printf(1, "condvar:  1 producer, %d consumers, %d items in %d ticks\n",
+         n - 1, iters, t);
+  ok &= consumed == iters;
+
+  printf(1, "futexbench: %s\n", ok ? "OK" : "FAIL");
+  exit();
+}
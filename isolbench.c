@@ -0,0 +1,88 @@
+// CPU isolation with affinity.
+//
+// isolbench [hogs] [rounds] runs a probe that sleeps for a tick and
+// then does a tick of work, for the given number of rounds (default
+// 100), next to CPU hogs (default two per CPU).  It runs twice:
+// once with everything free to run anywhere, and once with the
+// probe pinned to the last CPU and the hogs to the others.  For
+// each it prints the mean and worst lateness of a round in ticks,
+// that is how much longer than two ticks it took.  Pinning should
+// bring the lateness close to 0.  Needs CPUS= of at least 2.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "pstat.h"
+
+#define MAXHOGS  32
+
+struct cpustat cs[NCPU];
+int loops;  // spin() iterations per tick, measured while idle
+
+void
+run(char *name, int nhogs, int nrounds, int ncpu, int pin)
+{
+  int pid[MAXHOGS], i, late, sum, worst;
+  uint all, t;
+
+  all = (1 << ncpu) - 1;
+  for(i = 0; i < nhogs; i++){
+    if((pid[i] = fork()) < 0){
+      printf(2, "isolbench: fork failed\n");
+      nhogs = i;
+      break;
+    }
+    if(pid[i] == 0)
+      for(;;)
+        ;
+    if(pin)
+      setaffinity(pid[i], all >> 1);
+  }
+  setaffinity(getpid(), pin ? 1 << (ncpu - 1) : all);
+  sleep(1);
+
+  sum = worst = 0;
+  for(i = 0; i < nrounds; i++){
+    t = uptime();
+    sleep(1);
+    spin(loops);
+    late = uptime() - t - 2;
+    if(late < 0)
+      late = 0;
+    sum += late;
+    if(late > worst)
+      worst = late;
+  }
+  printf(1, "%s: mean lateness %d.%d ticks, worst %d\n", name,
+         sum / nrounds, (sum * 10 / nrounds) % 10, worst);
+
+  for(i = 0; i < nhogs; i++){
+    kill(pid[i]);
+    wait();
+  }
+  setaffinity(getpid(), all);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int nhogs, nrounds, ncpu;
+
+  ncpu = getcpustat(cs, NCPU);
+  nhogs = argc > 1 ? atoi(argv[1]) : 2 * ncpu;
+  nrounds = argc > 2 ? atoi(argv[2]) : 100;
+  if(nhogs < 0 || nhogs > MAXHOGS || nrounds <= 0){
+    printf(2, "usage: isolbench [hogs] [rounds]\n");
+    exit();
+  }
+  if(ncpu < 2){
+    printf(2, "isolbench: needs at least 2 CPUs\n");
+    exit();
+  }
+
+  loops = calibrate();
+  run("unpinned", nhogs, nrounds, ncpu, 0);
+  run("pinned  ", nhogs, nrounds, ncpu, 1);
+  exit();
+}
@@ -26,7 +26,9 @@ main(void)
   ioapicinit();    // another interrupt controller
   consoleinit();   // console hardware
   uartinit();      // serial port
+  tscinit();       // calibrate the cycle counter
   pinit();         // process table
+  rqinit();        // per-CPU run queues
   tvinit();        // trap vectors
   binit();         // buffer cache
   fileinit();      // file table
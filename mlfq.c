@@ -0,0 +1,65 @@
+// Show or change the MLFQ settings.
+//
+// mlfq                print them
+// mlfq name value...  change them, then print them
+//
+// The names are levels (levels in use), age (ticks a process waits
+// before moving up a level, 0 for never), boost (ticks between
+// moves of every process to level 0, 0 for never) and q0, q1, ...
+// (the time slice at each level, in ticks).  For example
+//   mlfq levels 3 q0 2 q1 4 q2 8 boost 500
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "pstat.h"
+
+void
+usage(void)
+{
+  printf(2, "usage: mlfq [levels n] [age n] [boost n] [q0 n] ... [q%d n]\n",
+         MAXQUEUE - 1);
+  exit();
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct mlfqparam mp;
+  int i, l, v;
+
+  if(argc % 2 == 0)
+    usage();
+  if(setmlfq(0, &mp) < 0){
+    printf(2, "mlfq: setmlfq failed\n");
+    exit();
+  }
+
+  if(argc > 1){
+    for(i = 1; i < argc; i += 2){
+      v = atoi(argv[i+1]);
+      if(strcmp(argv[i], "levels") == 0)
+        mp.nlevels = v;
+      else if(strcmp(argv[i], "age") == 0)
+        mp.age = v;
+      else if(strcmp(argv[i], "boost") == 0)
+        mp.boost = v;
+      else if(argv[i][0] == 'q' && argv[i][1] >= '0' && argv[i][1] <= '9' &&
+              (l = atoi(argv[i] + 1)) < MAXQUEUE)
+        mp.quantum[l] = v;
+      else
+        usage();
+    }
+    if(setmlfq(&mp, 0) < 0){
+      printf(2, "mlfq: settings out of range\n");
+      exit();
+    }
+    setmlfq(0, &mp);
+  }
+
+  printf(1, "levels %d, age %d, boost %d\n", mp.nlevels, mp.age, mp.boost);
+  for(l = 0; l < mp.nlevels; l++)
+    printf(1, "  q%d \t %d ticks\n", l, mp.quantum[l]);
+  exit();
+}
@@ -0,0 +1,52 @@
+// Print how busy each CPU has been, its load average, and how many
+// processes it has taken from other CPUs.
+//
+// mpstat            since boot
+// mpstat <command>  while the command runs
+//
+// The load average is the one at the end.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "pstat.h"
+
+struct cpustat before[NCPU], after[NCPU];
+
+int
+main(int argc, char *argv[])
+{
+  int n, i, pid;
+  uint idle, busy;
+
+  memset(before, 0, sizeof(before));
+  if(argc > 1){
+    getcpustat(before, NCPU);
+    pid = fork();
+    if(pid < 0){
+      printf(2, "mpstat: fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      exec(argv[1], argv + 1);
+      printf(2, "mpstat: exec %s failed\n", argv[1]);
+      exit();
+    }
+    wait();
+  }
+  n = getcpustat(after, NCPU);
+
+  printf(1, "CPU \t busy \t idle \t util \t load \t steals \t pulls\n");
+  for(i = 0; i < n; i++){
+    busy = after[i].busy - before[i].busy;
+    idle = after[i].idle - before[i].idle;
+    printf(1, "%d \t %d \t %d \t %d%% \t %d.%d%d \t %d \t %d\n",
+           after[i].cpu, busy, idle,
+           busy + idle > 0 ? busy * 100 / (busy + idle) : 0,
+           after[i].load / 100, after[i].load / 10 % 10, after[i].load % 10,
+           after[i].steals - before[i].steals,
+           after[i].pulls - before[i].pulls);
+  }
+  exit();
+}
@@ -1,4 +1,6 @@
+#ifndef NPROC
 #define NPROC        64  // maximum number of processes
+#endif
 #define KSTACKSIZE 4096  // size of per-process kernel stack
 #define NCPU          8  // maximum number of CPUs
 #define NOFILE       16  // open files per process
@@ -10,7 +12,15 @@
 #define MAXOPBLOCKS  10  // max # of blocks any FS op writes
 #define LOGSIZE      (MAXOPBLOCKS*3)  // max data blocks in on-disk log
 #define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
-#define FSSIZE       1000  // size of file system in blocks
+#define FSSIZE       2000  // size of file system in blocks
 #define MAXQUEUE     5   // maximum number of queues in MLFQ
-#define NUMQUEUE     NPROC // maximum number of processes in a queue
-#define AGE          200 // defining threshold for age in MLFQ
\ No newline at end of file
+#define AGE          200 // defining threshold for age in MLFQ
+#define BOOST        0   // ticks between MLFQ priority boosts (0: never)
+#define TICKETS      100 // default tickets for stride scheduling
+#define MAXTICKETS 10000 // most tickets a process can hold
+#define NSLEEPQ      61  // number of sleep queues wakeup() hashes into
+#define NPIDHASH  NPROC  // number of buckets in the pid hash
+#define MAXRTPERIOD 100000 // longest real-time period, in ticks
+#define BALANCE      4   // ticks between load balancing passes (0: never)
+#define IMBALANCE    150 // load difference, in hundredths of a process,
+                         // that makes a CPU pull work
\ No newline at end of file
@@ -6,24 +6,310 @@
 #include "x86.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "sleeplock.h"
+#include "sched.h"
+#include "pstat.h"
+
+// Locking.  Each process has its own lock, p->lock, which guards
+// p->state and what changes with it: p->chan, p->killed and
+// p->cpu.  A CPU holds p->lock from the moment p gives up its CPU,
+// through swtch(), until the scheduler has switched away from it,
+// so no other CPU can run p, and no one can free it, while it is
+// still on its old stack.
+//
+// The fields the run queues and policies use (the queue links,
+// cur_queue, vruntime, pass, the real-time budget) belong to p's
+// run queue lock while p is queued, to the CPU running p while it
+// runs, and otherwise to whoever holds p->lock.  A CPU that takes
+// p off another CPU's queue (see sched.c) owns p, which is on no
+// queue, until it can take p->lock; it changes p->cpu only then.
+// p->cpumask and p->tickets are changed under p->lock, and
+// p->priority under pilock, but the policies read them under a run
+// queue lock alone, so a change takes effect at the next pick or
+// tick.  scheduler() and rqenqueue() check the mask again under
+// p->lock before p runs or joins a queue.
+//
+// The other locks guard what is shared between processes:
+//
+//   ptable.lock   the free list, the pid hash and nextpid, address
+//                 space ids and counts, and the real-time total
+//   treelock      every process's parent, children and zombies,
+//                 and kill() setting p->killed, which wait checks
+//   sleepq lock   one sleep queue, and its statistics
+//   pilock        priority inheritance; see sleeplockwait()
+//   futexlock     futex checks; see futex_wait()
+//
+// Lock order: the lock passed to sleep(), or held by the caller
+// of wakeup(); treelock; futexlock; ptable.lock; pilock; p->lock;
+// then a sleep queue lock or a run queue lock.  Holding ptable.lock
+// keeps a process found with findproc() from being freed.
+//
+// sleep() and wakeup() cannot lose a wakeup.  The sleeper joins
+// its sleep queue before it releases the lock the caller holds
+// around its condition, and a waker that changes the condition
+// under that lock then searches the queue under the queue lock.
+// wakeup() takes p->lock only after releasing the queue lock, as
+// the order above requires, so in between p is SLEEPING but on no
+// queue.  It has chan 0 then, which tells kill() that a wakeup is
+// already on its way.
 
 struct {
   struct spinlock lock;
   struct proc proc[NPROC];
+  struct proc *pidhash[NPIDHASH]; // Allocated processes, hashed by pid
+  struct proc *freelist;         // Stack of UNUSED slots
+  int rtutil;                    // Sum of the real-time processes' rtutil
+  int vmref[NPROC];              // Processes using each address space
+  int vmfree[NPROC];             // Stack of unused address space ids
+  int nvmfree;
 } ptable;
 
+// Sleeping processes, hashed by chan.
+struct sleepq {
+  struct spinlock lock;
+  struct proc *head;
+  uint wakeups;                  // Calls to wakeupn() that searched here
+  uint scanned;                  // Processes those calls looked at
+} sleepqs[NSLEEPQ];
+
+static struct spinlock treelock;
+static struct spinlock pilock;
+static struct spinlock futexlock;
+
 static struct proc *initproc;
 
 int nextpid = 1;
 extern void forkret(void);
 extern void trapret(void);
 
-static void wakeup1(void *chan);
+// The sleep queue for chan.  Channels are kernel addresses, so
+// use the bits above the low ones that alignment keeps zero.
+static struct sleepq*
+sleepq(void *chan)
+{
+  return &sleepqs[((uint)chan >> 4) % NSLEEPQ];
+}
+
+// Unlink the sleeping process p from sq, the sleep queue of
+// p->chan, and clear p->chan.  sq->lock must be held.
+static void
+sleepqremove(struct sleepq *sq, struct proc *p)
+{
+  if(p->slprev)
+    p->slprev->slnext = p->slnext;
+  else
+    sq->head = p->slnext;
+  if(p->slnext)
+    p->slnext->slprev = p->slprev;
+  p->slnext = p->slprev = 0;
+  p->chan = 0;
+}
+
+// Move p to state s, charging the time since p's last state
+// change to the state it is leaving.  Every state change except
+// the final one to UNUSED goes through here.  p->lock must be
+// held, except for a new process no one else can run.
+// Returns the number of cycles p spent in the state it left.
+static uint64
+setstate(struct proc *p, enum procstate s)
+{
+  uint64 now = rdtsc(), d;
+
+  // CPUs' TSCs may be slightly out of step, and p may have
+  // changed state last on another CPU.  Never charge negative time.
+  d = now > p->tstamp ? now - p->tstamp : 0;
+  switch(p->state){
+  case RUNNING:
+    p->runcycles += d;
+    break;
+  case RUNNABLE:
+    p->waitcycles += d;
+    break;
+  case SLEEPING:
+    p->sleepcycles += d;
+    p->iotime += ticks - p->stateticks;
+    break;
+  default:
+    break;
+  }
+  p->tstamp = now;
+  p->stateticks = ticks;
+  p->state = s;
+  return d;
+}
+
+// The pid hash bucket for pid.  Pids are handed out in order,
+// so consecutive processes land in consecutive buckets.
+static struct proc**
+pidhash(int pid)
+{
+  return &ptable.pidhash[(uint)pid % NPIDHASH];
+}
+
+// Find the process with the given pid, or return 0.
+// The ptable lock must be held, and keeps it from being freed.
+static struct proc*
+findproc(int pid)
+{
+  struct proc *p;
+
+  if(pid <= 0)
+    return 0;
+  for(p = *pidhash(pid); p; p = p->pidnext)
+    if(p->pid == pid)
+      return p;
+  return 0;
+}
+
+// Return p's slot to the table: take it out of the pid hash,
+// mark it UNUSED and push it on the free list.  Its kernel stack
+// and page table must already be freed, and no CPU may still be
+// running on that stack.  The ptable lock must be held.
+static void
+freeproc(struct proc *p)
+{
+  struct proc **pp;
+
+  for(pp = pidhash(p->pid); *pp; pp = &(*pp)->pidnext){
+    if(*pp == p){
+      *pp = p->pidnext;
+      break;
+    }
+  }
+  p->pidnext = 0;
+  p->children = p->zombies = 0;
+  p->pid = 0;
+  p->parent = 0;
+  p->name[0] = 0;
+  p->killed = 0;
+  p->state = UNUSED;
+  p->freenext = ptable.freelist;
+  ptable.freelist = p;
+}
+
+// Push p onto the front of a children or zombies list.
+// treelock must be held.
+static void
+sibpush(struct proc **list, struct proc *p)
+{
+  p->sibprev = 0;
+  p->sibnext = *list;
+  if(*list)
+    (*list)->sibprev = p;
+  *list = p;
+}
+
+// Unlink p from the children or zombies list it is on.
+// treelock must be held.
+static void
+sibremove(struct proc **list, struct proc *p)
+{
+  if(p->sibprev)
+    p->sibprev->sibnext = p->sibnext;
+  else
+    *list = p->sibnext;
+  if(p->sibnext)
+    p->sibnext->sibprev = p->sibprev;
+  p->sibnext = p->sibprev = 0;
+}
+
+// Give every process on list *from to parent, moving them onto
+// the front of list *to.  Returns 1 if any moved.
+// treelock must be held.
+static int
+sibsplice(struct proc **from, struct proc **to, struct proc *parent)
+{
+  struct proc *p, *first = *from;
+
+  if(first == 0)
+    return 0;
+  for(p = first; ; p = p->sibnext){
+    p->parent = parent;
+    if(p->sibnext == 0)
+      break;
+  }
+  p->sibnext = *to;
+  if(*to)
+    (*to)->sibprev = p;
+  *to = first;
+  *from = 0;
+  return 1;
+}
 
 void
 pinit(void)
 {
+  struct proc *p;
+  int i;
+
   initlock(&ptable.lock, "ptable");
+  initlock(&treelock, "proctree");
+  initlock(&pilock, "pi");
+  initlock(&futexlock, "futex");
+  for(i = 0; i < NSLEEPQ; i++)
+    initlock(&sleepqs[i].lock, "sleepq");
+
+  // Stack the slots so that allocproc() hands out proc[0] first.
+  for(p = &ptable.proc[NPROC-1]; p >= ptable.proc; p--){
+    initlock(&p->lock, "proc");
+    p->freenext = ptable.freelist;
+    ptable.freelist = p;
+  }
+
+  // Every address space is used by at least one process, so
+  // there can never be more than NPROC of them.
+  for(i = 0; i < NPROC; i++)
+    ptable.vmfree[ptable.nvmfree++] = NPROC - 1 - i;
+}
+
+// An id for a new address space, with one user.
+// The ptable lock must be held.
+static int
+vmnew(void)
+{
+  int vm;
+
+  if(ptable.nvmfree == 0)
+    panic("vmnew");
+  vm = ptable.vmfree[--ptable.nvmfree];
+  ptable.vmref[vm] = 1;
+  return vm;
+}
+
+// Drop p's use of its address space, and free the page table
+// if no other thread still uses it.  The ptable lock must be held.
+static void
+vmput(struct proc *p)
+{
+  if(--ptable.vmref[p->vm] == 0){
+    freevm(p->pgdir);
+    ptable.vmfree[ptable.nvmfree++] = p->vm;
+  }
+  p->pgdir = 0;
+  p->vm = -1;
+}
+
+// Called by exec() once the current process has switched to its
+// new page table.  Drop its use of the old address space, whose
+// page table is oldpgdir, and give it a new one.  Other threads
+// that share the old address space keep running in it.
+void
+execvm(pde_t *oldpgdir)
+{
+  struct proc *curproc = myproc();
+
+  // wait() tells threads from child processes by vm, under treelock.
+  acquire(&treelock);
+  acquire(&ptable.lock);
+  if(ptable.vmref[curproc->vm] > 1){
+    ptable.vmref[curproc->vm]--;
+    curproc->vm = vmnew();
+    oldpgdir = 0;
+  }
+  release(&ptable.lock);
+  release(&treelock);
+  if(oldpgdir)
+    freevm(oldpgdir);
 }
 
 // Must be called with interrupts disabled
@@ -33,40 +319,37 @@ cpuid() {
 }
 
 // Must be called with interrupts disabled to avoid the caller being
-// rescheduled between reading lapicid and running through the loop.
+// rescheduled and then using another CPU's struct cpu.
+// seginit() points %gs at this CPU's struct cpu, so this is one load.
+// The load is volatile so that the compiler does not reuse it after
+// a swtch(), which may resume us on another CPU.
 struct cpu*
 mycpu(void)
 {
-  int apicid, i;
-  
+  struct cpu *c;
+
   if(readeflags()&FL_IF)
     panic("mycpu called with interrupts enabled\n");
-  
-  apicid = lapicid();
-  // APIC IDs are not guaranteed to be contiguous. Maybe we should have
-  // a reverse map, or reserve a register to store &cpus[i].
-  for (i = 0; i < ncpu; ++i) {
-    if (cpus[i].apicid == apicid)
-      return &cpus[i];
-  }
-  panic("unknown apicid\n");
+
+  asm volatile("movl %%gs:%c1, %0"
+               : "=r" (c) : "i" (__builtin_offsetof(struct cpu, self)));
+  return c;
 }
 
-// Disable interrupts so that we are not rescheduled
-// while reading proc from the cpu structure
+// One load through %gs, which is atomic, so interrupts need not be
+// disabled: if we are rescheduled to another CPU afterwards, that
+// CPU's proc is still this process.
 struct proc*
 myproc(void) {
-  struct cpu *c;
   struct proc *p;
-  pushcli();
-  c = mycpu();
-  p = c->proc;
-  popcli();
+
+  asm volatile("movl %%gs:%c1, %0"
+               : "=r" (p) : "i" (__builtin_offsetof(struct cpu, proc)));
   return p;
 }
 
 //PAGEBREAK: 32
-// Look in the process table for an UNUSED proc.
+// Take an UNUSED proc off the free list.
 // If found, change state to EMBRYO and initialize
 // state required to run in the kernel.
 // Otherwise return 0.
@@ -78,37 +361,49 @@ allocproc(void)
 
   acquire(&ptable.lock);
 
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    if(p->state == UNUSED)
-      goto found;
-
-  release(&ptable.lock);
-  return 0;
+  if((p = ptable.freelist) == 0){
+    release(&ptable.lock);
+    return 0;
+  }
+  ptable.freelist = p->freenext;
+  p->freenext = 0;
 
-found:
-  p->state = EMBRYO;
+  p->runcycles = p->waitcycles = p->sleepcycles = 0;
+  setstate(p, EMBRYO);
   p->pid   = nextpid++;
+  p->pidnext = *pidhash(p->pid);
+  *pidhash(p->pid) = p;
   p->ctime = ticks;
   p->etime = -1;
   p->rtime = 0;
   p->iotime = 0;
   p->priority = 60;                      // Default priority for a new process
+  p->basepriority = 60;
+  p->waitlock = 0;
+  p->held = 0;
   p->n_run = 0;
   p->reset_ticks = 0;
-  p->cur_queue = -1;
-  for (int i = 0; i < MAXQUEUE; i++)
-    p->ticks[i] = -1;
-  #ifdef MLFQ
   p->cur_queue = 0;
+  p->cpu = -1;
+  p->cpumask = (1 << ncpu) - 1;
+  p->vruntime = 0;
+  p->tickets = TICKETS;
+  p->pass = 0;
+  p->heapidx = -1;
+  p->rtperiod = 0;
+  p->rtutil = 0;
+  p->vm = -1;
+  p->ustack = 0;
   for (int i = 0; i < MAXQUEUE; i++)
-      p->ticks[i] = 0;
-  #endif
+    p->ticks[i] = 0;
 
   release(&ptable.lock);
 
   // Allocate kernel stack.
   if((p->kstack = kalloc()) == 0){
-    p->state = UNUSED;
+    acquire(&ptable.lock);
+    freeproc(p);
+    release(&ptable.lock);
     return 0;
   }
   sp = p->kstack + KSTACKSIZE;
@@ -157,36 +452,52 @@ userinit(void)
   safestrcpy(p->name, "initcode", sizeof(p->name));
   p->cwd = namei("/");
 
+  acquire(&ptable.lock);
+  p->vm = vmnew();
+  release(&ptable.lock);
+
   // this assignment to p->state lets other cores
   // run this process. the acquire forces the above
   // writes to be visible, and the lock is also needed
   // because the assignment might not be atomic.
-  acquire(&ptable.lock);
-
-  p->state = RUNNABLE;
-
-  release(&ptable.lock);
+  acquire(&p->lock);
+  setstate(p, RUNNABLE);
+  rqenqueue(p);
+  release(&p->lock);
 }
 
 // Grow current process's memory by n bytes.
-// Return 0 on success, -1 on failure.
+// Return the old size on success, -1 on failure.
 int
 growproc(int n)
 {
-  uint sz;
+  uint sz, oldsz;
+  struct proc *p;
   struct proc *curproc = myproc();
 
-  sz = curproc->sz;
+  // Threads share the address space, so resize it under the
+  // ptable lock and give every thread the new size.
+  acquire(&ptable.lock);
+  sz = oldsz = curproc->sz;
   if(n > 0){
-    if((sz = allocuvm(curproc->pgdir, sz, sz + n)) == 0)
+    if((sz = allocuvm(curproc->pgdir, sz, sz + n)) == 0){
+      release(&ptable.lock);
       return -1;
+    }
   } else if(n < 0){
-    if((sz = deallocuvm(curproc->pgdir, sz, sz + n)) == 0)
+    if((sz = deallocuvm(curproc->pgdir, sz, sz + n)) == 0){
+      release(&ptable.lock);
       return -1;
+    }
   }
   curproc->sz = sz;
+  if(ptable.vmref[curproc->vm] > 1)
+    for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+      if(p->vm == curproc->vm)
+        p->sz = sz;
+  release(&ptable.lock);
   switchuvm(curproc);
-  return 0;
+  return oldsz;
 }
 
 // Create a new process copying p as the parent.
@@ -208,11 +519,17 @@ fork(void)
   if((np->pgdir = copyuvm(curproc->pgdir, curproc->sz)) == 0){
     kfree(np->kstack);
     np->kstack = 0;
-    np->state = UNUSED;
+    acquire(&ptable.lock);
+    freeproc(np);
+    release(&ptable.lock);
     return -1;
   }
   np->sz = curproc->sz;
   np->parent = curproc;
+  np->vruntime = curproc->vruntime;
+  np->tickets = curproc->tickets;
+  np->pass = curproc->pass;
+  np->cpumask = curproc->cpumask;
   *np->tf = *curproc->tf;
 
   // Clear %eax so that fork returns 0 in the child.
@@ -228,11 +545,92 @@ fork(void)
   pid = np->pid;
 
   acquire(&ptable.lock);
+  np->vm = vmnew();
+  release(&ptable.lock);
+
+  acquire(&treelock);
+  sibpush(&curproc->children, np);
+  release(&treelock);
+
+  acquire(&np->lock);
+  setstate(np, RUNNABLE);
+  rqenqueue(np);
+  release(&np->lock);
+
+  return pid;
+}
+
+// Create a thread: a new process that shares the current process's
+// address space and starts by calling fcn(arg1, arg2) on the
+// one-page user stack at stack.  Like a forked child, it gets
+// references to the caller's open files and current directory.
+// Returns the thread's pid, or -1.
+int
+clone(void (*fcn)(void*, void*), void *arg1, void *arg2, void *stack)
+{
+  int i, pid;
+  uint sp, ustack[3];
+  struct proc *np;
+  struct proc *curproc = myproc();
+
+  if((uint)stack + PGSIZE < (uint)stack || (uint)stack + PGSIZE > curproc->sz)
+    return -1;
+
+  // Allocate process.
+  if((np = allocproc()) == 0){
+    return -1;
+  }
+
+  // Start at fcn(arg1, arg2), returning to a bad address.
+  ustack[0] = 0xffffffff;
+  ustack[1] = (uint)arg1;
+  ustack[2] = (uint)arg2;
+  sp = (uint)stack + PGSIZE - sizeof(ustack);
+  if(copyout(curproc->pgdir, sp, ustack, sizeof(ustack)) < 0){
+    kfree(np->kstack);
+    np->kstack = 0;
+    acquire(&ptable.lock);
+    freeproc(np);
+    release(&ptable.lock);
+    return -1;
+  }
+  np->pgdir = curproc->pgdir;
+  np->parent = curproc;
+  np->ustack = stack;
+  np->vruntime = curproc->vruntime;
+  np->tickets = curproc->tickets;
+  np->pass = curproc->pass;
+  np->cpumask = curproc->cpumask;
+  *np->tf = *curproc->tf;
+  np->tf->eip = (uint)fcn;
+  np->tf->esp = sp;
+
+  for(i = 0; i < NOFILE; i++)
+    if(curproc->ofile[i])
+      np->ofile[i] = filedup(curproc->ofile[i]);
+  np->cwd = idup(curproc->cwd);
+
+  safestrcpy(np->name, curproc->name, sizeof(curproc->name));
 
-  np->state = RUNNABLE;
+  pid = np->pid;
 
+  acquire(&ptable.lock);
+  // Read sz under the lock, so that a thread growing the address
+  // space in growproc() either sees np or has finished.
+  np->sz = curproc->sz;
+  np->vm = curproc->vm;
+  ptable.vmref[np->vm]++;
   release(&ptable.lock);
 
+  acquire(&treelock);
+  sibpush(&curproc->children, np);
+  release(&treelock);
+
+  acquire(&np->lock);
+  setstate(np, RUNNABLE);
+  rqenqueue(np);
+  release(&np->lock);
+
   return pid;
 }
 
@@ -243,7 +641,6 @@ void
 exit(void)
 {
   struct proc *curproc = myproc();
-  struct proc *p;
   int fd;
 
   if(curproc == initproc)
@@ -263,71 +660,127 @@ exit(void)
 
   curproc->cwd = 0;
 
+  // Give back its share of the CPUs if it is real-time.
   acquire(&ptable.lock);
+  ptable.rtutil -= curproc->rtutil;
+  curproc->rtutil = 0;
+  release(&ptable.lock);
+
+  acquire(&treelock);
 
   // Parent might be sleeping in wait().
-  wakeup1(curproc->parent);
+  wakeup(curproc->parent);
 
   // Pass abandoned children to init.
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-    if(p->parent == curproc){
-      p->parent = initproc;
-      if(p->state == ZOMBIE)
-        wakeup1(initproc);
-    }
-  }
+  sibsplice(&curproc->children, &initproc->children, initproc);
+  if(sibsplice(&curproc->zombies, &initproc->zombies, initproc))
+    wakeup(initproc);
+
+  // Move to the parent's list of exited children.  The parent
+  // may find us there at once, but it waits for curproc->lock
+  // before it frees anything, and we hold that until the
+  // scheduler has switched away from us.
+  sibremove(&curproc->parent->children, curproc);
+  sibpush(&curproc->parent->zombies, curproc);
 
   // Jump into the scheduler, never to return.
-  curproc->state = ZOMBIE;
+  acquire(&curproc->lock);
+  release(&treelock);
+  setstate(curproc, ZOMBIE);
   curproc->etime = ticks;                       // update the ending time for the process
   sched();
   panic("zombie exit");
 }
 
-// Wait for a child process to exit and return its pid.
-// Return -1 if this process has no children.
-int
-wait(void)
+// The first child on list that is a thread sharing curproc's
+// address space if thread is set, or a process with an address
+// space of its own if not, or 0.
+static struct proc*
+findchild(struct proc *list, struct proc *curproc, int thread)
 {
   struct proc *p;
-  int havekids, pid;
+
+  for(p = list; p; p = p->sibnext)
+    if((p->vm == curproc->vm) == thread)
+      return p;
+  return 0;
+}
+
+// Wait for a child to exit, free it, and return its pid.  If thread
+// is set, wait for a thread created by clone() and store its user
+// stack in *stack; otherwise wait for a child process.  If pt is not
+// 0, fill it in with the time the child spent in each state.
+// Return -1 if this process has no children of that kind.
+static int
+waitchild(int thread, struct proctime *pt, void **stack)
+{
+  struct proc *p;
+  int pid;
   struct proc *curproc = myproc();
   
-  acquire(&ptable.lock);
+  acquire(&treelock);
   for(;;){
-    // Scan through table looking for exited children.
-    havekids = 0;
-    for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-      if(p->parent != curproc)
-        continue;
-      havekids = 1;
-      if(p->state == ZOMBIE){
-        // Found one.
-        pid = p->pid;
-        kfree(p->kstack);
-        p->kstack = 0;
-        freevm(p->pgdir);
-        p->pid = 0;
-        p->parent = 0;
-        p->name[0] = 0;
-        p->killed = 0;
-        p->state = UNUSED;
-        release(&ptable.lock);
-        return pid;
+    // Reap an exited child if there is one.
+    if((p = findchild(curproc->zombies, curproc, thread)) != 0){
+      sibremove(&curproc->zombies, p);
+      // Wait until no CPU is still on p's kernel stack; see exit().
+      acquire(&p->lock);
+      release(&p->lock);
+      pid = p->pid;
+      if(pt){
+        pt->runcycles = p->runcycles;
+        pt->waitcycles = p->waitcycles;
+        pt->sleepcycles = p->sleepcycles;
+        pt->runus = cycles2us(p->runcycles);
+        pt->waitus = cycles2us(p->waitcycles);
+        pt->sleepus = cycles2us(p->sleepcycles);
+        pt->rtime = p->rtime;
+        pt->iotime = p->iotime;
+        if (p->etime != -1)
+            pt->wtime = p->etime - p->ctime - p->rtime - p->iotime;
+        else 
+            pt->wtime = ticks - p->ctime - p->rtime - p->iotime;
       }
+      if(stack)
+        *stack = p->ustack;
+      kfree(p->kstack);
+      p->kstack = 0;
+      acquire(&ptable.lock);
+      vmput(p);
+      freeproc(p);
+      release(&ptable.lock);
+      release(&treelock);
+      return pid;
     }
 
     // No point waiting if we don't have any children.
-    if(!havekids || curproc->killed){
-      release(&ptable.lock);
+    if(findchild(curproc->children, curproc, thread) == 0 || curproc->killed){
+      release(&treelock);
       return -1;
     }
 
-    // Wait for children to exit.  (See wakeup1 call in proc_exit.)
-    sleep(curproc, &ptable.lock);  //DOC: wait-sleep
+    // Wait for children to exit.  (See wakeup call in proc_exit.)
+    sleep(curproc, &treelock);  //DOC: wait-sleep
   }
 }
 
+// Wait for a child process to exit and return its pid.
+// Return -1 if this process has no children.
+int
+wait(void)
+{
+  return waitchild(0, 0, 0);
+}
+
+// Wait for a thread created by clone() to exit, store the stack
+// that was passed to clone() in *stack, and return its pid.
+// Return -1 if this process has no threads.
+int
+join(void **stack)
+{
+  return waitchild(1, 0, stack);
+}
+
 //PAGEBREAK: 42
 // Per-CPU process scheduler.
 // Each CPU calls scheduler() after setting itself up.
@@ -347,146 +800,48 @@ scheduler(void)
     // Enable interrupts on this processor.
     sti();
 
-    // Loop over process table looking for process to run.
-    acquire(&ptable.lock);
-    #ifdef RR
-    for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-      if(p->state != RUNNABLE)
-        continue;
-
-      // Switch to chosen process.  It is the process's job
-      // to release ptable.lock and then reacquire it
-      // before jumping back to us.
-      c->proc = p;
-      switchuvm(p);
-      p->state = RUNNING;
-
-      swtch(&(c->scheduler), p->context);
-      switchkvm();
-
-      // Process is done running for now.
-      // It should have changed its p->state before coming back.
-      c->proc = 0;
-    }
-    #else 
-    #ifdef FCFS
-    struct proc * firstComeProc = NULL;
-    for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    {
-        if (p->state == RUNNNABLE)
-        {
-            if (firstComeProc == NULL || firstComeProc->ctime > p->ctime)
-                firstComeProc = p;
-        }
-    }
-    // If no such process found, don't run the following
-    if (firstComeProc != NULL)
-    {
-        c->proc = firstComeProc;
-        switchuvm(firstComeProc);
-        firstComeProc->state = RUNNING;
-
-        swtch(&(c->scheduler), firstComeProc->context);
-        switchkvm();
-
-        // Process is done running for now.
-        // It should have changed its p->state before coming back.
-        c->proc = 0;
-    }
-    #else
-    #ifdef PBS
-    struct proc * minProc = NULL;
-    for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    {
-        if (p->state == RUNNABLE)
-        {
-            if (minProc == NULL)
-            {
-                minProc = p;
-            }
-            else
-            {
-                if (p->priority < minProc->priority
-                        || (p->priority <= minProc && p->n_run <= minProc->n_run))
-                {
-                    minProc = p;
-                }
-            }
-        }
-    }
-    if (minProc != NULL)
-    {
-        minProc->n_run += 1;
-
-        c->proc = minProc;
-        switchuvm(minProc);
-        minProc->state = RUNNING;
-        swtch(&(c->scheduler), minProc->context);
-        switchkvm();
-
-        // Process is done running for now.
-        // It should have changed its p->state before coming back.
-        c->proc = 0;
-    }
-    #else
-    #ifdef MLFQ
-
-    for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    {
-        if (p->state == RUNNABLE && p->queue == -1)    
-        {
-            pushback(&mlfq[0], p);
-            p->queue = 0;
-            p->reset_ticks = ticks;
-        }
-    }
-    struct proc *toRun = NULL;
-    
-    for (int que = 0; que < MAXQUEUE; que++)
-    {
-        if (size(&mlfq[que]) > 0)
-        {
-            toRun = mlfq[que].q[mlfq[que].beg];
-
-            if (toRun == NULL)
-                continue;
-
-            if (toRun->state == RUNNABLE)
-                break;
-            else
-                deletefront(&mlfq[que]);
-        }
+    // Take the next process off this CPU's run queue, stealing
+    // one from another CPU if the local queue is empty.
+    if((p = rqpick(c - cpus)) == 0){
+      rqidle(c - cpus);
+      continue;
     }
-    if (toRun != NULL && toRun->state == RUNNABLE)
-    {
-        toRun->n_run += 1;
-        toRun->reset_ticks = ticks;
-        c->proc = toRun;
-        switchuvm(toRun);
-        toRun->state = RUNNING;
-
-        swtch(&(c->scheduler), toRun->context);
 
-        if (toRun->state == SLEEPING)
-        {
-            struct proc * del = mlfq[p->queue].q[q->beg];
-            deletefront(&mlfq[p->queue]);
-            pushback(&mlfq[p->queue], del);
-        }
-
-        switchkvm();
-
-        c->proc = 0;
+    // Switch to chosen process.  It is the process's job
+    // to release p->lock and then reacquire it
+    // before jumping back to us.  Acquiring p->lock also
+    // waits for a process that queued itself in yield() on
+    // another CPU to finish switching away.
+    acquire(&p->lock);
+    if(p->state != RUNNABLE)
+      panic("scheduler: not runnable");
+    // setaffinity() may have taken this CPU out of p's mask since
+    // p was queued.  rqenqueue() moves it to a CPU in the mask.
+    if((p->cpumask & (1 << (c - cpus))) == 0){
+      rqenqueue(p);
+      release(&p->lock);
+      continue;
     }
-    #endif
-    #endif
-    #endif
-    #endif
-    release(&ptable.lock);
+    rqclaim(p, c - cpus);
+    p->n_run += 1;
+    p->reset_ticks = ticks;
+    c->proc = p;
+    c->resched = 0;
+    switchuvm(p);
+    // The time p spent RUNNABLE is its dispatch latency.
+    rqlatency(c - cpus, setstate(p, RUNNING));
+
+    swtch(&(c->scheduler), p->context);
+    switchkvm();
+
+    // Process is done running for now.
+    // It should have changed its p->state before coming back.
+    c->proc = 0;
+    release(&p->lock);
   }
 }
 
-// Enter scheduler.  Must hold only ptable.lock
+// Enter scheduler.  Must hold only p->lock
 // and have changed proc->state. Saves and restores
 // intena because intena is a property of this
 // kernel thread, not this CPU. It should
@@ -499,8 +854,8 @@ sched(void)
   int intena;
   struct proc *p = myproc();
 
-  if(!holding(&ptable.lock))
-    panic("sched ptable.lock");
+  if(!holding(&p->lock))
+    panic("sched p->lock");
   if(mycpu()->ncli != 1)
     panic("sched locks");
   if(p->state == RUNNING)
@@ -516,10 +871,13 @@ sched(void)
 void
 yield(void)
 {
-  acquire(&ptable.lock);  //DOC: yieldlock
-  myproc()->state = RUNNABLE;
+  struct proc *p = myproc();
+
+  acquire(&p->lock);  //DOC: yieldlock
+  setstate(p, RUNNABLE);
+  rqenqueue(p);
   sched();
-  release(&ptable.lock);
+  release(&p->lock);
 }
 
 // A fork child's very first scheduling by scheduler()
@@ -528,8 +886,8 @@ void
 forkret(void)
 {
   static int first = 1;
-  // Still holding ptable.lock from scheduler.
-  release(&ptable.lock);
+  // Still holding p->lock from scheduler.
+  release(&myproc()->lock);
 
   if (first) {
     // Some initialization functions must be run in the context
@@ -549,65 +907,225 @@ void
 sleep(void *chan, struct spinlock *lk)
 {
   struct proc *p = myproc();
-  
+  struct sleepq *sq;
+
   if(p == 0)
     panic("sleep");
 
   if(lk == 0)
     panic("sleep without lk");
 
-  // Must acquire ptable.lock in order to
+  // Must acquire p->lock in order to
   // change p->state and then call sched.
-  // Once we hold ptable.lock, we can be
+  // Once we are on the sleep queue for chan, we can be
   // guaranteed that we won't miss any wakeup
-  // (wakeup runs with ptable.lock locked),
+  // (wakeup searches it with its lock held),
   // so it's okay to release lk.
-  if(lk != &ptable.lock){  //DOC: sleeplock0
-    acquire(&ptable.lock);  //DOC: sleeplock1
-    release(lk);
-  }
-  // Go to sleep.
+  acquire(&p->lock);  //DOC: sleeplock1
+  sq = sleepq(chan);
+  acquire(&sq->lock);
   p->chan = chan;
-  p->state = SLEEPING;
+  setstate(p, SLEEPING);
+  p->slprev = 0;
+  p->slnext = sq->head;
+  if(p->slnext)
+    p->slnext->slprev = p;
+  sq->head = p;
+  release(&sq->lock);
+  release(lk);
 
   sched();
 
-  // Tidy up.
-  p->chan = 0;
-
+  // wakeup() or kill() has cleared p->chan.
   // Reacquire original lock.
-  if(lk != &ptable.lock){  //DOC: sleeplock2
-    release(&ptable.lock);
-    acquire(lk);
-  }
+  release(&p->lock);  //DOC: sleeplock2
+  acquire(lk);
 }
 
 //PAGEBREAK!
-// Wake up all processes sleeping on chan.
-// The ptable lock must be held.
-static void
-wakeup1(void *chan)
+// Wake up at most n processes sleeping on chan, or all of them
+// if n is negative, and return the number woken.
+// Only the sleep queue chan hashes to is searched.  The processes
+// are taken off it first, chained through slnext, and then made
+// RUNNABLE one at a time under their own locks.
+static int
+wakeupn(void *chan, int n)
 {
-  struct proc *p;
-
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-    if(p->state == SLEEPING && p->chan == chan){
-      p->state = RUNNABLE;
-    #ifdef MLFQ
-      q->reset_ticks = ticks;
-      pushback(&mlfq[p->queue], p);
-    #endif   
+  struct sleepq *sq = sleepq(chan);
+  struct proc *p, *next, *woken, **end;
+  int nwoken = 0;
+
+  end = &woken;
+  acquire(&sq->lock);
+  sq->wakeups++;
+  for(p = sq->head; p && nwoken != n; p = next){
+    next = p->slnext;
+    sq->scanned++;
+    if(p->chan == chan){
+      sleepqremove(sq, p);
+      *end = p;
+      end = &p->slnext;
+      nwoken++;
     }
   }
+  *end = 0;
+  release(&sq->lock);
+
+  // Once p is RUNNABLE it may run and sleep again, reusing slnext,
+  // so read it first.  Acquiring p->lock waits for a sleeper that
+  // has not yet switched away.
+  for(p = woken; p; p = next){
+    next = p->slnext;
+    p->slnext = 0;
+    acquire(&p->lock);
+    setstate(p, RUNNABLE);
+    rqenqueue(p);
+    release(&p->lock);
+  }
+  return nwoken;
 }
 
 // Wake up all processes sleeping on chan.
 void
 wakeup(void *chan)
 {
+  wakeupn(chan, -1);
+}
+
+//PAGEBREAK!
+// Priority inheritance for sleep locks.  While a process waits for
+// a sleep lock, the holder runs at the better of its own priority
+// and the waiter's, and so does the holder of any sleep lock that
+// holder is waiting for, and so on down the chain.  Otherwise a
+// high-priority process could wait for a low-priority holder that
+// never runs because of processes in between, e.g. under PBS.
+//
+// p->basepriority is p's own priority.  lk->waitpri is the best
+// priority lent through lk since it was last released, and
+// p->priority is the best of p->basepriority and the waitpri of
+// every lock p holds; p->held lists those.  waitpri, priority and
+// the chain walk are guarded by pilock.  lk->holder is set by
+// acquiresleep() under lk->lk alone, and cleared below under both,
+// so a walker never follows a lock to a process that has already
+// given it back.  p->held is only changed and read by p itself.
+
+// Lend the current process's priority to the holder of lk, which
+// it is about to sleep on.  Called by acquiresleep() with lk->lk
+// held, so lk->holder cannot change.
+void
+sleeplockwait(struct sleeplock *lk)
+{
+  struct proc *p = myproc(), *h;
+  int pri, n;
+
+  acquire(&pilock);
+  p->waitlock = lk;
+  pri = p->priority;
+  // Bounded, in case of a deadlock cycle.
+  for(n = 0; lk && (h = lk->holder) != 0 && n < NPROC; n++){
+    if(pri < lk->waitpri)
+      lk->waitpri = pri;
+    if(h->priority <= pri)
+      break;
+    h->priority = pri;
+    lk = h->waitlock;
+  }
+  release(&pilock);
+}
+
+// Called by releasesleep() with lk->lk held instead of wakeup(lk).
+// Drops lk from the holder's locks, takes back what waiters lent
+// through it, and wakes them.
+void
+sleeplockrelease(struct sleeplock *lk)
+{
+  struct proc *p = lk->holder;
+  struct sleeplock **pp, *l;
+  int pri;
+
+  acquire(&pilock);
+  if(p){
+    for(pp = &p->held; *pp; pp = &(*pp)->heldnext){
+      if(*pp == lk){
+        *pp = lk->heldnext;
+        break;
+      }
+    }
+    pri = p->basepriority;
+    for(l = p->held; l; l = l->heldnext)
+      if(l->waitpri < pri)
+        pri = l->waitpri;
+    p->priority = pri;
+  }
+  lk->holder = 0;
+  lk->heldnext = 0;
+  lk->waitpri = 100;
+  release(&pilock);
+  wakeup(lk);
+}
+
+//PAGEBREAK!
+// Futexes: sleeping on a word of user memory.  The sleep channel
+// is the word's kernel address.  That names the physical memory
+// rather than the user address, so every thread or process that
+// maps the page finds the same channel.  A user page is never also
+// a kernel object, so the channel cannot clash with other sleepers.
+
+// The channel for the user word at addr in the current process,
+// or 0 if addr is not a word-aligned user address.
+// The ptable lock must be held, so that growproc() cannot unmap
+// the page meanwhile.
+static int*
+futexkey(int *addr)
+{
+  struct proc *curproc = myproc();
+  char *ka;
+
+  if(((uint)addr & 3) != 0 || (uint)addr >= curproc->sz)
+    return 0;
+  if((ka = uva2ka(curproc->pgdir, (char*)addr)) == 0)
+    return 0;
+  return (int*)(ka + ((uint)addr & (PGSIZE-1)));
+}
+
+// If the word at addr still holds val, sleep until futex_wake() is
+// called on the same word.  Checking the word and going to sleep
+// both happen under futexlock, which futex_wake() also takes,
+// so a wakeup that follows a change to the word cannot be missed.
+// Returns 0 once woken, or -1 if the word did not hold val, addr
+// is bad, or the process has been killed.
+int
+futex_wait(int *addr, int val)
+{
+  int *key;
+
+  acquire(&futexlock);
+  acquire(&ptable.lock);
+  if((key = futexkey(addr)) == 0 || *key != val){
+    release(&ptable.lock);
+    release(&futexlock);
+    return -1;
+  }
+  release(&ptable.lock);
+  sleep(key, &futexlock);
+  release(&futexlock);
+  return myproc()->killed ? -1 : 0;
+}
+
+// Wake at most n processes sleeping in futex_wait() on the word at
+// addr.  Returns the number woken, or -1 if addr is bad.
+int
+futex_wake(int *addr, int n)
+{
+  int *key, woken;
+
+  acquire(&futexlock);
   acquire(&ptable.lock);
-  wakeup1(chan);
+  key = futexkey(addr);
   release(&ptable.lock);
+  woken = key ? wakeupn(key, n) : -1;
+  release(&futexlock);
+  return woken;
 }
 
 // Kill the process with the given pid.
@@ -617,24 +1135,41 @@ int
 kill(int pid)
 {
   struct proc *p;
+  struct sleepq *sq;
+  void *chan;
 
+  // treelock keeps this out from between waitchild()'s check of
+  // p->killed and its sleep, where p is still RUNNING and would
+  // miss the wakeup below.
+  acquire(&treelock);
   acquire(&ptable.lock);
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-    if(p->pid == pid){
-      p->killed = 1;
-      // Wake process from sleep if necessary.
-      if(p->state == SLEEPING)
-        p->state = RUNNABLE;
-      #ifdef MLFQ
-      p->reset_ticks = ticks;
-      pushback(&mlfq[p->queue], p);
-      #endif
-      release(&ptable.lock);
-      return 0;
+  if((p = findproc(pid)) == 0){
+    release(&ptable.lock);
+    release(&treelock);
+    return -1;
+  }
+  acquire(&p->lock);
+  p->killed = 1;
+  // Wake process from sleep if necessary.  If p->chan is 0, a
+  // wakeup() has already taken it off its queue and will do it;
+  // one may also do so before we get the queue lock.
+  if(p->state == SLEEPING && (chan = p->chan) != 0){
+    sq = sleepq(chan);
+    acquire(&sq->lock);
+    if(p->chan != 0)
+      sleepqremove(sq, p);
+    else
+      chan = 0;
+    release(&sq->lock);
+    if(chan){
+      setstate(p, RUNNABLE);
+      rqenqueue(p);
     }
   }
+  release(&p->lock);
   release(&ptable.lock);
-  return -1;
+  release(&treelock);
+  return 0;
 }
 
 //PAGEBREAK: 36
@@ -670,9 +1205,8 @@ procdump(void)
       for(i=0; i<10 && pc[i] != 0; i++)
         cprintf(" %p", pc[i]);
     }
-#ifdef MLFQ
-    cprintf(" queue: %d", p->queue);
-#endif
+    if(getscheduler() == SCHED_MLFQ)
+      cprintf(" queue: %d", p->cur_queue);
     cprintf("\n");
   }
 }
@@ -682,64 +1216,41 @@ procdump(void)
 int 
 waitx(int* wtime, int* rtime)
 {
-  struct proc *p;
-  int havekids, pid;
-  struct proc *curproc = myproc();
-  
-  acquire(&ptable.lock);
-  for(;;){
-    // Scan through table looking for exited children.
-    havekids = 0;
-    for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-
-      if(p->parent != curproc)
-        continue;
-
-      havekids = 1;
+    struct proctime pt;
+    int pid;
 
-      if(p->state == ZOMBIE){
-        // Found one.
-        pid = p->pid;
-        if (p->etime != -1)
-            *wtime = p->etime - p->ctime - p->rtime - p->iotime;
-        else 
-            *wtime = ticks - p->ctime - p->rtime - p->iotime;
-        *rtime = p->rtime;
-        kfree(p->kstack);
-        p->kstack = 0;
-        freevm(p->pgdir);
-        p->pid = 0;
-        p->parent = 0;
-        p->name[0] = 0;
-        p->killed = 0;
-        p->state = UNUSED;
-        release(&ptable.lock);
-        return pid;
-      }
-    }
-
-    // No point waiting if we don't have any children.
-    if(!havekids || curproc->killed){
-      release(&ptable.lock);
-      return -1;
+    if ((pid = waitstat(&pt)) >= 0)
+    {
+        *wtime = pt.wtime;
+        *rtime = pt.rtime;
     }
+    return pid;
+}
 
-    // Wait for children to exit.  (See wakeup1 call in proc_exit.)
-    sleep(curproc, &ptable.lock);  //DOC: wait-sleep
-  }
-
+// Wait for a child process to exit, fill in *pt with the time it
+// spent in each state, and return its pid.
+// Return -1 if this process has no children.
+int
+waitstat(struct proctime *pt)
+{
+  return waitchild(0, pt, 0);
 }
 
 int
 getps(void)
 {
-    struct proc* p;
+    struct proc *q, *p, snap;
     char* states[] = { "UNUSED", "EMBRYO", "SLEEPING", "RUNNABLE", "RUNNING", "ZOMBIE" };
 
-    acquire(&ptable.lock);
     cprintf("PID \t PRIORITY \t State \t\t r_time \t w_time \t n_run \t cur_q \t q0 \t q1 \t q2 \t q3 \t q4\n");
-    for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    for (q = ptable.proc; q < &ptable.proc[NPROC]; q++)
     {
+        // Print a copy taken under q's lock: the console lock
+        // comes before p->lock, since consoleintr() calls wakeup().
+        acquire(&q->lock);
+        snap = *q;
+        release(&q->lock);
+        p = &snap;
         if (p->pid <= 0)
             continue;
         // change the given wtime using reset_ticks
@@ -753,9 +1264,8 @@ getps(void)
         }
         if (wtime < 0)
             cprintf("Etime: [%d]\tCtime: [%d]\tRtime: [%d]\tIOTime: [%d]\n", p->etime, p->ctime, p->rtime, p->iotime);
-        #ifdef MLFQ
-            wtime = ticks - p->reset_ticks;   
-        #endif
+        if (getscheduler() == SCHED_MLFQ)
+            wtime = ticks - p->reset_ticks;
         cprintf("%d \t %d \t\t ", p->pid, p->priority);
         cprintf("%s \t %d \t\t ", states[p->state], p->rtime);
         cprintf("%d \t\t %d \t ", wtime, p->n_run);
@@ -764,11 +1274,52 @@ getps(void)
             cprintf(" %d \t", p->ticks[i]);
         cprintf("\n");
     }
-    release(&ptable.lock);
 
     return 0;
 }
 
+// Copy the details of up to n processes into pi, without printing
+// anything while holding a process's lock.  Returns the number of
+// processes copied.
+int
+getpinfo(struct procinfo *pi, int n)
+{
+  struct proc *p;
+  int i, k;
+
+  k = 0;
+  for(p = ptable.proc; p < &ptable.proc[NPROC] && k < n; p++){
+    acquire(&p->lock);
+    if(p->state == UNUSED){
+      release(&p->lock);
+      continue;
+    }
+    pi[k].pid = p->pid;
+    pi[k].state = p->state;
+    safestrcpy(pi[k].name, p->name, sizeof(pi[k].name));
+    pi[k].priority = p->priority;
+    pi[k].queue = p->cur_queue;
+    for(i = 0; i < MAXQUEUE; i++)
+      pi[k].ticks[i] = p->ticks[i];
+    pi[k].rtime = p->rtime;
+    // As in getps(): under MLFQ, the time since p last ran or
+    // changed level.
+    if(getscheduler() == SCHED_MLFQ)
+      pi[k].wtime = ticks - p->reset_ticks;
+    else if(p->etime >= 0)
+      pi[k].wtime = p->etime - p->ctime - p->rtime - p->iotime;
+    else
+      pi[k].wtime = ticks - p->ctime - p->rtime - p->iotime;
+    if(pi[k].wtime < 0)
+      pi[k].wtime = 0;
+    pi[k].n_run = p->n_run;
+    pi[k].sz = p->sz;
+    release(&p->lock);
+    k++;
+  }
+  return k;
+}
+
 int 
 set_priority(int new_priority, int pid)
 {
@@ -779,132 +1330,126 @@ set_priority(int new_priority, int pid)
         cprintf("<new-priority> for the process should be between 0-100!\n");
         return -1;
     }
-	acquire(&ptable.lock);
-	for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-	  if(p->pid == pid){
-            old_priority = p->priority;
-			p->priority = new_priority;
-			break;
-		}
-	}
-	release(&ptable.lock);
-    #ifdef PBS
-    if (old_priority < new_priority)
+    acquire(&ptable.lock);
+    if ((p = findproc(pid)) != 0)
+    {
+        // A priority inherited through a sleep lock stays until
+        // the lock is released.
+        acquire(&pilock);
+        old_priority = p->basepriority;
+        if (p->priority == p->basepriority || new_priority < p->priority)
+            p->priority = new_priority;
+        p->basepriority = new_priority;
+        release(&pilock);
+    }
+    release(&ptable.lock);
+    if (getscheduler() == SCHED_PBS && old_priority < new_priority)
         yield();
-    #endif
-	return old_priority;
+    return old_priority;
 }
 
-#ifdef MLFQ
-
-void pushback(Queue *q, struct proc *p)
+// Let the process with the given pid run only on the CPUs whose
+// bits are set in mask, and return its old mask.  A mask of 0 only
+// returns the current one.  Returns -1 if there is no such process
+// or mask has no CPU that exists.  A process running on a CPU
+// outside the new mask is made to yield, and a queued one moves
+// when it is next picked; see scheduler().
+int
+setaffinity(int pid, uint mask)
 {
-    if (!q)
-        panic("Invalid Queue given!\n");
-    if (!p)
-        panic("Invalid Process given!\n");
-
-    if (size(q) == NUMQUEUE) 
-        panic("The Queue is full!\n")
+  struct proc *p;
+  int old = -1;
 
-     if (q->beg > 0)
-        for (int i = q->beg; i != (q->end + 1) % NUMQUEUE; i++, i %= NUMQUEUE)
-            if (q->q[i] != NULL && q->q[i]->pid == p->pid)
-                return;
-    
-    if (q->beg == -1)
-    {
-        q->q[0] = p;
-        q->beg = q->end = 0;
-    }
-    else if (q->end == NUMQUEUE - 1 && q->beg != 0)
-    {
-        q->end = 0;
-        q->q[0] = p;
-    }
-    else
-    {
-        q->end++;
-        q->q[q->end] = p;
+  if(mask && (mask & ((1 << ncpu) - 1)) == 0)
+    return -1;
+  mask &= (1 << ncpu) - 1;
+  acquire(&ptable.lock);
+  if((p = findproc(pid)) != 0){
+    acquire(&p->lock);
+    old = p->cpumask;
+    if(mask){
+      p->cpumask = mask;
+      if(p->state == RUNNING && (mask & (1 << p->cpu)) == 0)
+        rqpreempt(p->cpu);
     }
+    release(&p->lock);
+  }
+  release(&ptable.lock);
+  return old;
 }
 
-void deletefront(Queue *q)
+// Give the process with the given pid the given number of
+// tickets, which sets its CPU share under STRIDE.
+// Returns its old number of tickets, or -1 if there is no such
+// process.
+int
+settickets(int tickets, int pid)
 {
-    if (!q)
-        panic("Invalid Queue given!\n");
+  struct proc *p;
+  int old = -1;
 
-    if (q->beg == -1)
-        panic("Deleting from empty queue!\n");
+  if(tickets < 1 || tickets > MAXTICKETS)
+    return -1;
 
-    if (q->beg == q->end)
-        q->end = q->beg = -1;
-    else if (q->beg == NUMQUEUE - 1)
-        q->beg = 0;
-    else
-        q->beg++;
+  acquire(&ptable.lock);
+  if((p = findproc(pid)) != 0){
+    acquire(&p->lock);
+    old = p->tickets;
+    p->tickets = tickets;
+    release(&p->lock);
+  }
+  release(&ptable.lock);
+  return old;
 }
 
-void deleteIdx(Queue *q, int idx)
+// Make the current process real-time: in every period of the
+// given number of ticks it may run for budget ticks, ahead of all
+// processes that are not real-time, earliest deadline first.
+// A period of 0 makes it an ordinary process again.  Fails if the
+// real-time processes together would need more than every CPU.
+int
+setrt(int period, int budget)
 {
-    if (idx < q->beg || idx > q->end)
-        panic("Invalid idx!\n");
+  struct proc *p = myproc();
+  int util = 0;
 
-    for (int i = idx; i != (q->end + 1) % NUMQUEUE; i++, i %= NUMQUEUE)
-       q->q[i] = q->q[(j + 1) % NUMQUEUE];
+  if(period < 0 || period > MAXRTPERIOD)
+    return -1;
+  if(period > 0){
+    if(budget < 1 || budget > period)
+      return -1;
+    util = (budget * 1000 + period - 1) / period;  // round up
+  }
 
-    if (q->beg == q->end)
-        q->beg = q->end = -1;
-    else if (q->end == 0 && q->beg > q->end)
-        q->end = NUMQUEUE - 1;
-    else
-        q->end--;
+  acquire(&ptable.lock);
+  if(ptable.rtutil - p->rtutil + util > ncpu * 1000){
+    release(&ptable.lock);
+    return -1;
+  }
+  ptable.rtutil += util - p->rtutil;
+  p->rtutil = util;
+  acquire(&p->lock);
+  p->rtperiod = period;
+  p->rtbudget = budget;
+  p->rtleft = budget;
+  p->deadline = ticks + period;
+  release(&p->lock);
+  release(&ptable.lock);
+  return 0;
 }
 
-int size(Queue *q)
+// Report how many times wakeupn() has run and how many sleeping
+// processes it has looked at in total.  The sleep queues are read
+// without their locks, so the totals may miss a call in progress.
+int
+wakestat(int *wakeups, int *scanned)
 {
-    if (q == NULL)
-        panic("Invalid Queue given!\n");
-
-    if (q->beg == -1)
-        return 0;
-    
-    if (q->end >= q->beg)
-        return q->end - q->beg + 1;
-
-    return NUMQUEUE + q->end - q->beg;
-}
+  int i;
 
-void 
-ageproc(void)
-{
-    for (int que = 0; que < MAXQUEUE; que++)
-    {
-        if (size(&mlfq[que]))
-        {
-            Queue *q = &mlfq[que];
-            
-            for (int i = q->beg; i != (q->end + 1) % NUMQUEUE; i++, i %= NUMQUEUE)
-            {
-                if (q->q[i] && ticks - q->reset_ticks > AGE)
-                {
-                    if (q->q[i]->queue < 0)
-                        continue;
-                    int newQ = q->q[i]->queue - 1;
-                    if (newQ < 0)
-                        newQ = 0;
-
-                    struct proc *del = mlfq[q->q[i]->queue].q[i];
-                    deleteIdx(&mlfq[q->q[i]->queue], i);
-
-                    del->reset_ticks = ticks;
-                    del->queue = newQ;
-
-                    pushback(&mlfq[newQ], del);
-                }
-            }
-        }
-    }
+  *wakeups = *scanned = 0;
+  for(i = 0; i < NSLEEPQ; i++){
+    *wakeups += sleepqs[i].wakeups;
+    *scanned += sleepqs[i].scanned;
+  }
+  return 0;
 }
-
-#endif
\ No newline at end of file
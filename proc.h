@@ -1,7 +1,10 @@
 #include "param.h"
+#include "spinlock.h"
 
-// Per-CPU state
+// Per-CPU state.  Each one starts on its own cache line, so that
+// CPUs writing their own fields do not slow each other down.
 struct cpu {
+  struct cpu *self;            // This struct; mycpu() loads it via %gs
   uchar apicid;                // Local APIC ID
   struct context *scheduler;   // swtch() here to enter scheduler
   struct taskstate ts;         // Used by x86 to find stack for interrupt
@@ -10,7 +13,11 @@ struct cpu {
   int ncli;                    // Depth of pushcli nesting.
   int intena;                  // Were interrupts enabled before pushcli?
   struct proc *proc;           // The process running on this cpu or null
-};
+  volatile uint idle;          // Halted in rqidle(), waiting for work?
+  volatile uint resched;       // Should the running process yield now?
+  uint idleticks;              // Timer ticks with no process running
+  uint busyticks;              // Timer ticks with a process running
+} __attribute__((aligned(64)));
 
 extern struct cpu cpus[NCPU];
 extern int ncpu;
@@ -38,6 +45,7 @@ enum procstate { UNUSED, EMBRYO, SLEEPING, RUNNABLE, RUNNING, ZOMBIE };
 
 // Per-process state
 struct proc {
+  struct spinlock lock;        // Guards state changes; see proc.c
   uint sz;                     // Size of process memory (bytes)
   uint ctime;                  // Creation time for the process
   int etime;                  // End time for the process
@@ -60,24 +68,44 @@ struct proc {
   int n_run;                   // Number of times the process is executed
   int cur_queue;               // Current queue
   int ticks[MAXQUEUE];         // Number of ticks the process receives at the `i`th queue
+  uint boostepoch;             // MLFQ boost period cur_queue was set in
+  int cpu;                     // CPU whose run queue holds or last held the process
+  uint cpumask;                // CPUs the process may run on, bit i for CPU i
+  struct proc *rqnext;         // Next process on the run queue
+  struct proc *rqprev;         // Previous process on the run queue
+  uint vruntime;               // Weighted run time under CFS
+  struct proc *rbleft;         // CFS run queue tree links
+  struct proc *rbright;
+  struct proc *rbparent;
+  int rbcolor;
+  int tickets;                 // Share of the CPU under STRIDE
+  uint pass;                   // Stride scheduling virtual time
+  int heapidx;                 // Index in the STRIDE run queue heap
+  struct proc *slnext;         // Next process on the same sleep queue
+  struct proc *slprev;         // Previous process on the same sleep queue
+  struct proc *pidnext;        // Next process in the same pid hash bucket
+  struct proc *freenext;       // Next UNUSED slot on the free list
+  struct proc *children;       // Children that have not exited
+  struct proc *zombies;        // Children that have exited but not been waited for
+  struct proc *sibnext;        // Next process on the parent's children or zombies
+  struct proc *sibprev;        // Previous process on the same list
+  uint64 tstamp;               // TSC at the last state change
+  uint stateticks;             // ticks at the last state change
+  uint64 runcycles;            // TSC cycles spent RUNNING
+  uint64 waitcycles;           // TSC cycles spent RUNNABLE
+  uint64 sleepcycles;          // TSC cycles spent SLEEPING
+  int rtperiod;                // Real-time period in ticks, or 0 if not real-time
+  int rtbudget;                // Ticks it may run in each period
+  int rtleft;                  // Budget left in the current period
+  uint deadline;               // End of the current period
+  int rtutil;                  // rtbudget/rtperiod, in thousandths of a CPU
+  int vm;                      // Address space, shared by threads (see clone())
+  void *ustack;                // User stack passed to clone()
+  int basepriority;            // Priority before inheritance (see sleeplockwait())
+  struct sleeplock *waitlock;  // Sleep lock being waited for
+  struct sleeplock *held;      // Sleep locks held, linked through heldnext
 };
 
-#ifdef MLFQ
-
-typedef struct Queue {
-    int beg,                   // Beginning index of the array
-        end;                   // End index of the array (inclusive)
-    struct proc *q[NUMQUEUE];  // Array of `struct proc` pointers
-} Queue;
-Queue mlfq[MAXQUEUE];
-
-void pushback(Queue *, struct proc *);          // pushing the given process to the end of the Queue
-void deletefront(Queue *);                      // Deleting the process with the given pid
-void deleteIdx(Queue *, int);                   // Deleting the process for the given index in the Queue (for ageing of the processes)
-int size(Queue *);                              // Returns size of the Queue
-void ageproc(void);                             // Ageing the processes 
-
-#endif
 // Process memory is laid out contiguously, low addresses first:
 //   text
 //   original data and bss
@@ -3,14 +3,33 @@
 #include "stat.h"
 #include "user.h"
 #include "fcntl.h"
+#include "param.h"
+#include "pstat.h"
+
+char *states[] = { "UNUSED", "EMBRYO", "SLEEPING", "RUNNABLE", "RUNNING", "ZOMBIE" };
+
+struct procinfo pi[NPROC];
 
 int 
 main(int argc, char **argv)
 {
+    int n, i, j;
+
     if (argc > 1){ 
         printf(2, "ps usage: ps\n");
         exit();
     }
-    getps();
+    n = getpinfo(pi, NPROC);
+    printf(1, "PID \t PRIORITY \t State \t\t r_time \t w_time \t n_run \t cur_q \t q0 \t q1 \t q2 \t q3 \t q4 \t size \t name\n");
+    for (i = 0; i < n; i++)
+    {
+        printf(1, "%d \t %d \t\t ", pi[i].pid, pi[i].priority);
+        printf(1, "%s \t %d \t\t ", states[pi[i].state], pi[i].rtime);
+        printf(1, "%d \t\t %d \t ", pi[i].wtime, pi[i].n_run);
+        printf(1, "%d \t", pi[i].queue);
+        for (j = 0; j < MAXQUEUE; j++)
+            printf(1, " %d \t", pi[i].ticks[j]);
+        printf(1, " %d \t %s\n", pi[i].sz, pi[i].name);
+    }
     exit();
-}
\ No newline at end of file
+}
@@ -0,0 +1,64 @@
+// Statistics the kernel reports to user programs, and the
+// scheduler settings they can read and change.
+
+// Per-CPU time, in timer ticks, load and migrations, returned by
+// getcpustat().
+struct cpustat {
+  int cpu;       // CPU number
+  uint idle;     // Ticks with no process to run
+  uint busy;     // Ticks spent running a process
+  uint load;     // Decayed average of processes queued or running,
+                 // in hundredths
+  uint steals;   // Processes taken from other CPUs while idle
+  uint pulls;    // Processes taken from busier CPUs by the balancer
+};
+
+// Time an exited child spent in each state, returned by waitstat().
+struct proctime {
+  uint64 runcycles;    // TSC cycles spent running
+  uint64 waitcycles;   // TSC cycles spent runnable, waiting for a CPU
+  uint64 sleepcycles;  // TSC cycles spent sleeping
+  uint64 runus;        // The same three, in microseconds
+  uint64 waitus;
+  uint64 sleepus;
+  int rtime;           // Ticks spent running, as waitx() reports
+  int wtime;           // Ticks spent waiting, as waitx() reports
+  int iotime;          // Ticks spent sleeping
+};
+
+// One process, as returned by getpinfo().  Include param.h
+// before this file.
+struct procinfo {
+  int pid;
+  int state;             // enum procstate in proc.h
+  char name[16];
+  int priority;
+  int queue;             // Current MLFQ level
+  int ticks[MAXQUEUE];   // Ticks received at each MLFQ level
+  int rtime;             // Ticks spent running
+  int wtime;             // Ticks spent waiting
+  int n_run;             // Number of times scheduled
+  uint sz;               // Size of process memory, in bytes
+};
+
+#define NLATBUCKET 32  // log2 buckets in a dispatch latency histogram
+
+// How long processes waited between becoming RUNNABLE and being
+// dispatched on one CPU under one policy, from getschedlat().
+// count[i] is the number of waits of 2^i to 2^(i+1)-1 microseconds;
+// count[0] also counts waits under 1 microsecond.
+struct schedlat {
+  int cpu;
+  int policy;                // SCHED_ constant from sched.h
+  uint count[NLATBUCKET];
+};
+
+// MLFQ settings, for setmlfq().  Include param.h before this file.
+struct mlfqparam {
+  int nlevels;             // Levels in use, 1 to MAXQUEUE
+  int quantum[MAXQUEUE];   // Time slice at each level, in ticks
+  int age;                 // Ticks a process waits before moving up
+                           // a level; 0 for never
+  int boost;               // Ticks between moves of every process to
+                           // level 0; 0 for never
+};
@@ -0,0 +1,85 @@
+// Deadline test for the real-time scheduling class.
+//
+// rttest [hogs] [period] [budget] forks CPU-bound hogs, then runs a
+// periodic loop that needs about half its budget of CPU in every
+// period.  It runs the loop first as an ordinary process and then
+// after setrt(period, budget), and reports in how many periods the
+// work finished after the deadline each time.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NHOGS     4       // default number of CPU hogs
+#define PERIOD    10      // default period, in ticks
+#define BUDGET    4       // default budget, in ticks
+#define NPERIODS  50      // periods to run the loop for
+#define MAXHOGS   32
+
+int loops;  // spin() iterations per tick, measured while idle
+
+// Run the periodic loop and return the number of missed deadlines.
+int
+run(int period, int work)
+{
+  uint start, deadline, now;
+  int i, missed;
+
+  missed = 0;
+  start = uptime();
+  for(i = 0; i < NPERIODS; i++){
+    deadline = start + (i + 1) * period;
+    spin(work * loops);
+    now = uptime();
+    if(now > deadline)
+      missed++;
+    else if(now < deadline)
+      sleep(deadline - now);
+  }
+  return missed;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int nhogs, period, budget, work, i, missed;
+  int pid[MAXHOGS];
+
+  nhogs = argc > 1 ? atoi(argv[1]) : NHOGS;
+  period = argc > 2 ? atoi(argv[2]) : PERIOD;
+  budget = argc > 3 ? atoi(argv[3]) : BUDGET;
+  if(nhogs < 0 || nhogs > MAXHOGS || period <= 0 || budget <= 0 || budget > period){
+    printf(2, "usage: rttest [hogs] [period] [budget]\n");
+    exit();
+  }
+  work = budget / 2 > 0 ? budget / 2 : 1;
+  loops = calibrate();
+
+  for(i = 0; i < nhogs; i++){
+    if((pid[i] = fork()) < 0){
+      printf(2, "rttest: fork failed\n");
+      nhogs = i;
+      break;
+    }
+    if(pid[i] == 0)
+      for(;;)
+        ;
+  }
+
+  missed = run(period, work);
+  printf(1, "ordinary:  missed %d of %d deadlines\n", missed, NPERIODS);
+
+  if(setrt(period, budget) < 0){
+    printf(2, "rttest: setrt(%d, %d) refused\n", period, budget);
+  } else {
+    missed = run(period, work);
+    printf(1, "real-time: missed %d of %d deadlines\n", missed, NPERIODS);
+    setrt(0, 0);
+  }
+
+  for(i = 0; i < nhogs; i++){
+    kill(pid[i]);
+    wait();
+  }
+  exit();
+}
@@ -0,0 +1,1443 @@
+// Per-CPU run queues and scheduling policies.
+//
+// Every RUNNABLE process is linked into the run queue of the CPU
+// it last ran on (p->cpu).  Each queue has its own lock, so a CPU
+// chooses its next process without scanning ptable or touching
+// ptable.lock.  A CPU whose queue is empty steals from the busiest
+// other queue.  The scheduling policy only ever chooses among the
+// processes on one queue.
+//
+// Each CPU also keeps a load average, updated on every timer tick
+// by rqtimer().  Every BALANCE ticks a CPU compares it with the
+// others' and, if one is well above its own, pulls a process from
+// that CPU's queue (rqbalance()).  Stealing only helps CPUs with
+// nothing to do; this evens out queues that are merely uneven.
+//
+// p->cpumask (see setaffinity()) holds the CPUs p may run on.  A
+// process never joins, or is stolen onto, a queue outside its mask,
+// and only CPUs in the mask are woken for it.
+//
+// Real-time processes (see setrt()) come before every policy.
+// Among those whose budget is not used up, the one with the
+// earliest deadline runs.
+//
+// All policies are compiled in.  Each one is a table of operations
+// on a run queue (struct schedpolicy), and setscheduler() switches
+// between them while the system runs.  SCHEDULER= in the Makefile
+// picks the policy the kernel boots with.
+//
+// A CPU with nothing to run halts in rqidle().  rqenqueue() sends
+// an IPI to wake an idle CPU when it queues work, and marks a busy
+// CPU for rescheduling if the process it queued outranks the one
+// running there.
+//
+// Lock order: p->lock, then a run queue lock (see proc.c).  Only
+// setscheduler() and setmlfq() hold more than one run queue lock;
+// they take them all, in index order.  A process taken off a queue
+// by another CPU is on no queue until that CPU holds its lock:
+// rqsteal() leaves p->cpu for scheduler() to change with rqclaim(),
+// and rqbalance() drops the queue lock and takes p->lock before it
+// moves the process.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "x86.h"
+#include "proc.h"
+#include "spinlock.h"
+#include "traps.h"
+#include "sched.h"
+#include "pstat.h"
+
+// Each queue keeps one FIFO list per MLFQ level, linked through
+// p->rqnext/rqprev, and a bitmap of the levels that are non-empty.
+// RR, FCFS and PBS only use level 0.  CFS instead keeps the queue
+// in a red-black tree ordered by virtual runtime, and STRIDE in a
+// binary min-heap ordered by pass.
+struct runq {
+  struct spinlock lock;
+  struct proc *head[MAXQUEUE]; // Oldest process on each level
+  struct proc *tail[MAXQUEUE]; // Newest process on each level
+  uint levels;                 // Bit i set if level i is non-empty
+  struct proc *rbroot;         // CFS tree
+  struct proc *rbfirst;        // Leftmost node: smallest vruntime
+  uint min_vruntime;           // Never decreases
+  struct proc *heap[NPROC];    // Stride min-heap ordered by pass
+  int nheap;                   // Number of entries in heap
+  uint minpass;                // Never decreases
+  struct proc *rthead;         // Real-time processes, unordered
+  uint boostepoch;             // Last MLFQ boost period applied
+  int nrunnable;               // Number of processes on the queue
+  int nthrottled;              // Real-time ones among them that are out
+                               // of budget until their next period
+  uint load;                   // Decayed average of processes queued
+                               // or running, times LOADSCALE
+  uint nticks;                 // Timer ticks taken by this CPU
+  uint nsteal;                 // Processes stolen by this CPU while idle
+  uint npull;                  // Processes pulled here by rqbalance()
+  uint lat[NSCHED][NLATBUCKET]; // Dispatch latency histogram per policy
+} runq[NCPU];
+
+// A scheduling policy.  Every operation is called with the run
+// queue's lock held.
+struct schedpolicy {
+  char *name;
+  void (*enqueue)(struct runq*, struct proc*);  // add p to the queue
+  void (*dequeue)(struct runq*, struct proc*);  // remove p from the queue
+  struct proc* (*pick)(struct runq*);           // next to run, or 0
+  int (*tick)(struct runq*, struct proc*);      // charge a tick to running p;
+                                                // 1 if p should yield
+  int (*preempt)(struct runq*, struct proc*, struct proc*);
+                                                // 1 if p, just queued, should
+                                                // preempt running q
+  struct proc* (*tail)(struct runq*, int);      // last to run of those that
+                                                // may run on a CPU, or 0
+};
+
+static struct schedpolicy policies[NSCHED];
+static struct schedpolicy *policy;
+
+// MLFQ settings.  setmlfq() changes them with every run queue
+// locked, so holding any one run queue lock keeps them still.
+static struct mlfqparam mlfq;
+
+// Virtual runtimes and stride passes wrap around, so compare
+// them by the sign of their difference.
+#define VLT(a, b)   ((int)((a) - (b)) < 0)
+
+// Load averages are kept in hundredths of a process.
+#define LOADSCALE   100
+
+// Set up empty run queues and the boot policy and MLFQ settings.
+// schedsim calls this again before each run, so that no state
+// carries over from one run to the next.
+void
+rqinit(void)
+{
+  int i;
+
+  memset(runq, 0, sizeof(runq));
+  for(i = 0; i < NCPU; i++)
+    initlock(&runq[i].lock, "runq");
+
+  mlfq.nlevels = MAXQUEUE;
+  for(i = 0; i < MAXQUEUE; i++)
+    mlfq.quantum[i] = 1 << i;
+  mlfq.age = AGE;
+  mlfq.boost = BOOST;
+
+#ifdef FCFS
+  policy = &policies[SCHED_FCFS];
+#else
+#ifdef PBS
+  policy = &policies[SCHED_PBS];
+#else
+#ifdef MLFQ
+  policy = &policies[SCHED_MLFQ];
+#else
+#ifdef CFS
+  policy = &policies[SCHED_CFS];
+#else
+#ifdef STRIDE
+  policy = &policies[SCHED_STRIDE];
+#else
+  policy = &policies[SCHED_RR];
+#endif
+#endif
+#endif
+#endif
+#endif
+}
+
+//PAGEBREAK!
+// FIFO lists, used by RR, FCFS, PBS and MLFQ.
+
+// Append p to level l of rq.
+static void
+listpush(struct runq *rq, struct proc *p, int l)
+{
+  p->rqnext = 0;
+  p->rqprev = rq->tail[l];
+  if(rq->tail[l])
+    rq->tail[l]->rqnext = p;
+  else
+    rq->head[l] = p;
+  rq->tail[l] = p;
+  rq->levels |= 1 << l;
+}
+
+// Unlink p from level l of rq.
+static void
+listremove(struct runq *rq, struct proc *p, int l)
+{
+  if(p->rqprev)
+    p->rqprev->rqnext = p->rqnext;
+  else
+    rq->head[l] = p->rqnext;
+  if(p->rqnext)
+    p->rqnext->rqprev = p->rqprev;
+  else
+    rq->tail[l] = p->rqprev;
+  if(rq->head[l] == 0)
+    rq->levels &= ~(1 << l);
+  p->rqnext = p->rqprev = 0;
+}
+
+static void
+fifoenqueue(struct runq *rq, struct proc *p)
+{
+  listpush(rq, p, 0);
+}
+
+static void
+fifodequeue(struct runq *rq, struct proc *p)
+{
+  listremove(rq, p, 0);
+}
+
+// Round robin: the process that has waited longest, for one tick.
+static struct proc*
+rrpick(struct runq *rq)
+{
+  return rq->head[0];
+}
+
+static int
+rrtick(struct runq *rq, struct proc *p)
+{
+  return 1;
+}
+
+// The newest process that may run on cpu, from the lowest level
+// that has one.  RR, FCFS, PBS and MLFQ run it last, or nearly so.
+static struct proc*
+fifotail(struct runq *rq, int cpu)
+{
+  struct proc *p;
+  uint levels;
+  int l;
+
+  for(levels = rq->levels; levels; levels &= ~(1 << l)){
+    l = 31 - __builtin_clz(levels);
+    for(p = rq->tail[l]; p; p = p->rqprev)
+      if(p->cpumask & (1 << cpu))
+        return p;
+  }
+  return 0;
+}
+
+// RR switches at the next tick anyway, and FCFS never does.
+static int
+nopreempt(struct runq *rq, struct proc *p, struct proc *q)
+{
+  return 0;
+}
+
+// First come first served: the oldest process, until it blocks.
+static struct proc*
+fcfspick(struct runq *rq)
+{
+  struct proc *p, *best = rq->head[0];
+
+  for(p = rq->head[0]; p; p = p->rqnext)
+    if(p->ctime < best->ctime)
+      best = p;
+  return best;
+}
+
+static int
+fcfstick(struct runq *rq, struct proc *p)
+{
+  return 0;
+}
+
+// Priority based: the smallest priority value, preferring the
+// process that has run fewer times.
+static struct proc*
+pbspick(struct runq *rq)
+{
+  struct proc *p, *best = rq->head[0];
+
+  for(p = rq->head[0]; p; p = p->rqnext)
+    if(p->priority < best->priority ||
+       (p->priority == best->priority && p->n_run < best->n_run))
+      best = p;
+  return best;
+}
+
+static int
+pbspreempt(struct runq *rq, struct proc *p, struct proc *q)
+{
+  return p->priority < q->priority;
+}
+
+//PAGEBREAK!
+// Multi-level feedback queue.  p->cur_queue is p's level.  Only
+// the first mlfq.nlevels levels are used.
+//
+// Every mlfq.boost ticks, all processes go back to level 0.  Time
+// is cut into boost periods, and rather than walking every process
+// when one starts, each queue and each process records the period
+// its levels date from.  A queue moves its processes up when it
+// next picks, and a process that was running or asleep is moved up
+// when it is next queued.
+
+static uint
+mlfqepoch(void)
+{
+  return mlfq.boost ? ticks / mlfq.boost : 0;
+}
+
+static void
+mlfqenqueue(struct runq *rq, struct proc *p)
+{
+  uint epoch = mlfqepoch();
+
+  if(p->boostepoch != epoch){
+    p->boostepoch = epoch;
+    p->cur_queue = 0;
+  }
+  if(p->cur_queue >= mlfq.nlevels)
+    p->cur_queue = mlfq.nlevels - 1;
+  listpush(rq, p, p->cur_queue);
+}
+
+static void
+mlfqdequeue(struct runq *rq, struct proc *p)
+{
+  listremove(rq, p, p->cur_queue);
+}
+
+// If a boost period has started since rq last looked, move every
+// process on it to level 0.
+static void
+mlfqboost(struct runq *rq)
+{
+  struct proc *p;
+  uint epoch = mlfqepoch();
+  int l;
+
+  if(rq->boostepoch == epoch)
+    return;
+  rq->boostepoch = epoch;
+  for(p = rq->head[0]; p; p = p->rqnext)
+    p->boostepoch = epoch;
+  for(l = 1; l < MAXQUEUE; l++){
+    while((p = rq->head[l]) != 0){
+      listremove(rq, p, l);
+      p->cur_queue = 0;
+      p->boostepoch = epoch;
+      p->reset_ticks = ticks;
+      listpush(rq, p, 0);
+    }
+  }
+}
+
+// Move processes that have waited more than mlfq.age ticks up a
+// level.  Each level is in arrival order and p->reset_ticks is the
+// time p joined it, so only the head of each level needs checking.
+static void
+mlfqage(struct runq *rq)
+{
+  struct proc *p;
+  int l;
+
+  if(mlfq.age == 0)
+    return;
+  for(l = 1; l < MAXQUEUE; l++){
+    while((p = rq->head[l]) != 0 && ticks - p->reset_ticks > mlfq.age){
+      listremove(rq, p, l);
+      p->cur_queue--;
+      p->reset_ticks = ticks;
+      listpush(rq, p, l-1);
+    }
+  }
+}
+
+// The longest-waiting process on the highest non-empty level.
+static struct proc*
+mlfqpick(struct runq *rq)
+{
+  mlfqboost(rq);
+  mlfqage(rq);
+  return rq->levels ? rq->head[__builtin_ctz(rq->levels)] : 0;
+}
+
+// Charge the tick to p's current level.  Once p has used up that
+// level's time slice, move it down a level and preempt it.
+static int
+mlfqtick(struct runq *rq, struct proc *p)
+{
+  p->ticks[p->cur_queue]++;
+  if(ticks - p->reset_ticks >= mlfq.quantum[p->cur_queue]){
+    if(p->cur_queue < mlfq.nlevels - 1)
+      p->cur_queue++;
+    return 1;
+  }
+  return 0;
+}
+
+static int
+mlfqpreempt(struct runq *rq, struct proc *p, struct proc *q)
+{
+  return p->cur_queue < q->cur_queue;
+}
+
+//PAGEBREAK!
+// Completely fair scheduling: run the process with the smallest
+// weighted virtual runtime.
+
+#define CFS_TICK    1024        // vruntime of one tick at nice 0
+#define CFS_GRAN    CFS_TICK    // lead a process keeps before preemption
+#define CFS_CREDIT  (4*CFS_TICK) // most a waker can lag min_vruntime
+
+// Load weight of each nice level from -20 to 19, as in Linux.
+// One level is worth about 10% of CPU time; nice 0 weighs 1024.
+static const int niceweight[40] = {
+  88761, 71755, 56483, 46273, 36291,
+  29154, 23254, 18705, 14949, 11916,
+   9548,  7620,  6100,  4904,  3906,
+   3121,  2501,  1991,  1586,  1277,
+   1024,   820,   655,   526,   423,
+    335,   272,   215,   172,   137,
+    110,    87,    70,    56,    45,
+     36,    29,    23,    18,    15,
+};
+
+// Weight of p.  Priorities run from 0 (best) to 100, and the
+// default of 60 is nice 0; every two points is one nice level.
+static int
+cfsweight(struct proc *p)
+{
+  int nice = ((int)p->priority - 60) / 2;
+
+  if(nice < -20)
+    nice = -20;
+  if(nice > 19)
+    nice = 19;
+  return niceweight[nice + 20];
+}
+
+#define RB_RED    0
+#define RB_BLACK  1
+
+// Replace subtree u by subtree v in u's parent.
+static void
+rbtransplant(struct runq *rq, struct proc *u, struct proc *v)
+{
+  if(u->rbparent == 0)
+    rq->rbroot = v;
+  else if(u == u->rbparent->rbleft)
+    u->rbparent->rbleft = v;
+  else
+    u->rbparent->rbright = v;
+  if(v)
+    v->rbparent = u->rbparent;
+}
+
+static void
+rbrotleft(struct runq *rq, struct proc *x)
+{
+  struct proc *y = x->rbright;
+
+  x->rbright = y->rbleft;
+  if(y->rbleft)
+    y->rbleft->rbparent = x;
+  rbtransplant(rq, x, y);
+  y->rbleft = x;
+  x->rbparent = y;
+}
+
+static void
+rbrotright(struct runq *rq, struct proc *x)
+{
+  struct proc *y = x->rbleft;
+
+  x->rbleft = y->rbright;
+  if(y->rbright)
+    y->rbright->rbparent = x;
+  rbtransplant(rq, x, y);
+  y->rbright = x;
+  x->rbparent = y;
+}
+
+static struct proc*
+rbmin(struct proc *x)
+{
+  if(x)
+    while(x->rbleft)
+      x = x->rbleft;
+  return x;
+}
+
+static struct proc*
+rbmax(struct proc *x)
+{
+  if(x)
+    while(x->rbright)
+      x = x->rbright;
+  return x;
+}
+
+// The node before x in vruntime order, or 0.
+static struct proc*
+rbprev(struct proc *x)
+{
+  struct proc *y;
+
+  if(x->rbleft)
+    return rbmax(x->rbleft);
+  while((y = x->rbparent) != 0 && x == y->rbleft)
+    x = y;
+  return y;
+}
+
+// Insert z into the tree.  Equal keys go to the right, so
+// processes with the same vruntime run in arrival order.
+static void
+rbinsert(struct runq *rq, struct proc *z)
+{
+  struct proc *x, *y, *g, *u;
+  int left = 0;
+
+  y = 0;
+  for(x = rq->rbroot; x; x = left ? x->rbleft : x->rbright){
+    y = x;
+    left = VLT(z->vruntime, x->vruntime);
+  }
+  z->rbparent = y;
+  z->rbleft = z->rbright = 0;
+  z->rbcolor = RB_RED;
+  if(y == 0)
+    rq->rbroot = z;
+  else if(left)
+    y->rbleft = z;
+  else
+    y->rbright = z;
+  if(rq->rbfirst == 0 || VLT(z->vruntime, rq->rbfirst->vruntime))
+    rq->rbfirst = z;
+
+  // Restore the red-black properties.
+  while((y = z->rbparent) != 0 && y->rbcolor == RB_RED){
+    g = y->rbparent;
+    if(y == g->rbleft){
+      u = g->rbright;
+      if(u && u->rbcolor == RB_RED){
+        y->rbcolor = u->rbcolor = RB_BLACK;
+        g->rbcolor = RB_RED;
+        z = g;
+        continue;
+      }
+      if(z == y->rbright){
+        rbrotleft(rq, y);
+        z = y;
+        y = z->rbparent;
+      }
+      y->rbcolor = RB_BLACK;
+      g->rbcolor = RB_RED;
+      rbrotright(rq, g);
+    } else {
+      u = g->rbleft;
+      if(u && u->rbcolor == RB_RED){
+        y->rbcolor = u->rbcolor = RB_BLACK;
+        g->rbcolor = RB_RED;
+        z = g;
+        continue;
+      }
+      if(z == y->rbleft){
+        rbrotright(rq, y);
+        z = y;
+        y = z->rbparent;
+      }
+      y->rbcolor = RB_BLACK;
+      g->rbcolor = RB_RED;
+      rbrotleft(rq, g);
+    }
+  }
+  rq->rbroot->rbcolor = RB_BLACK;
+}
+
+// Remove z from the tree.
+static void
+rberase(struct runq *rq, struct proc *z)
+{
+  struct proc *x, *xp, *y, *w;
+  int color;
+
+  y = z;
+  color = y->rbcolor;
+  if(z->rbleft == 0){
+    x = z->rbright;
+    xp = z->rbparent;
+    rbtransplant(rq, z, x);
+  } else if(z->rbright == 0){
+    x = z->rbleft;
+    xp = z->rbparent;
+    rbtransplant(rq, z, x);
+  } else {
+    y = rbmin(z->rbright);
+    color = y->rbcolor;
+    x = y->rbright;
+    if(y->rbparent == z){
+      xp = y;
+    } else {
+      xp = y->rbparent;
+      rbtransplant(rq, y, x);
+      y->rbright = z->rbright;
+      y->rbright->rbparent = y;
+    }
+    rbtransplant(rq, z, y);
+    y->rbleft = z->rbleft;
+    y->rbleft->rbparent = y;
+    y->rbcolor = z->rbcolor;
+  }
+  z->rbleft = z->rbright = z->rbparent = 0;
+  if(rq->rbfirst == z)
+    rq->rbfirst = rbmin(rq->rbroot);
+  if(color == RB_RED)
+    return;
+
+  // x (possibly null, with parent xp) carries an extra black.
+  while(x != rq->rbroot && (x == 0 || x->rbcolor == RB_BLACK)){
+    if(x == xp->rbleft){
+      w = xp->rbright;
+      if(w->rbcolor == RB_RED){
+        w->rbcolor = RB_BLACK;
+        xp->rbcolor = RB_RED;
+        rbrotleft(rq, xp);
+        w = xp->rbright;
+      }
+      if((w->rbleft == 0 || w->rbleft->rbcolor == RB_BLACK) &&
+         (w->rbright == 0 || w->rbright->rbcolor == RB_BLACK)){
+        w->rbcolor = RB_RED;
+        x = xp;
+        xp = x->rbparent;
+      } else {
+        if(w->rbright == 0 || w->rbright->rbcolor == RB_BLACK){
+          w->rbleft->rbcolor = RB_BLACK;
+          w->rbcolor = RB_RED;
+          rbrotright(rq, w);
+          w = xp->rbright;
+        }
+        w->rbcolor = xp->rbcolor;
+        xp->rbcolor = RB_BLACK;
+        if(w->rbright)
+          w->rbright->rbcolor = RB_BLACK;
+        rbrotleft(rq, xp);
+        x = rq->rbroot;
+      }
+    } else {
+      w = xp->rbleft;
+      if(w->rbcolor == RB_RED){
+        w->rbcolor = RB_BLACK;
+        xp->rbcolor = RB_RED;
+        rbrotright(rq, xp);
+        w = xp->rbleft;
+      }
+      if((w->rbleft == 0 || w->rbleft->rbcolor == RB_BLACK) &&
+         (w->rbright == 0 || w->rbright->rbcolor == RB_BLACK)){
+        w->rbcolor = RB_RED;
+        x = xp;
+        xp = x->rbparent;
+      } else {
+        if(w->rbleft == 0 || w->rbleft->rbcolor == RB_BLACK){
+          w->rbright->rbcolor = RB_BLACK;
+          w->rbcolor = RB_RED;
+          rbrotleft(rq, w);
+          w = xp->rbleft;
+        }
+        w->rbcolor = xp->rbcolor;
+        xp->rbcolor = RB_BLACK;
+        if(w->rbleft)
+          w->rbleft->rbcolor = RB_BLACK;
+        rbrotright(rq, xp);
+        x = rq->rbroot;
+      }
+    }
+  }
+  if(x)
+    x->rbcolor = RB_BLACK;
+}
+static void
+cfsenqueue(struct runq *rq, struct proc *p)
+{
+  // A new process, or one that slept for a long time, only gets
+  // a small head start over the processes already waiting.
+  if(VLT(p->vruntime, rq->min_vruntime - CFS_CREDIT))
+    p->vruntime = rq->min_vruntime - CFS_CREDIT;
+  rbinsert(rq, p);
+}
+
+static void
+cfsdequeue(struct runq *rq, struct proc *p)
+{
+  rberase(rq, p);
+
+  // p is about to run or move, so the queue's minimum can
+  // advance to the smaller of p and the new leftmost.
+  if(rq->rbfirst && VLT(rq->rbfirst->vruntime, p->vruntime)){
+    if(VLT(rq->min_vruntime, rq->rbfirst->vruntime))
+      rq->min_vruntime = rq->rbfirst->vruntime;
+  } else if(VLT(rq->min_vruntime, p->vruntime))
+    rq->min_vruntime = p->vruntime;
+}
+
+// The process that is furthest behind its fair share.
+static struct proc*
+cfspick(struct runq *rq)
+{
+  return rq->rbfirst;
+}
+
+// Charge the tick to p's virtual runtime.  Preempt p once another
+// process on its queue has fallen more than CFS_GRAN behind it.
+static int
+cfstick(struct runq *rq, struct proc *p)
+{
+  p->vruntime += CFS_TICK * 1024 / cfsweight(p);
+  return rq->rbfirst != 0 &&
+         VLT(rq->rbfirst->vruntime + CFS_GRAN, p->vruntime);
+}
+
+// The same test as cfstick(), for a process that has just woken.
+static int
+cfspreempt(struct runq *rq, struct proc *p, struct proc *q)
+{
+  return VLT(p->vruntime + CFS_GRAN, q->vruntime);
+}
+
+// The process with the largest vruntime that may run on cpu.
+static struct proc*
+cfstail(struct runq *rq, int cpu)
+{
+  struct proc *p;
+
+  for(p = rbmax(rq->rbroot); p; p = rbprev(p))
+    if(p->cpumask & (1 << cpu))
+      return p;
+  return 0;
+}
+
+//PAGEBREAK!
+// Stride scheduling: run the process with the smallest pass, and
+// advance the pass of a process by its stride for every tick.
+
+#define STRIDE1     (1 << 20)   // stride of a process holding one ticket
+
+static void
+heapset(struct runq *rq, int i, struct proc *p)
+{
+  rq->heap[i] = p;
+  p->heapidx = i;
+}
+
+// Move the entry at i towards the root until its parent has a
+// smaller pass.
+static void
+heapup(struct runq *rq, int i)
+{
+  struct proc *p = rq->heap[i];
+
+  while(i > 0 && VLT(p->pass, rq->heap[(i-1)/2]->pass)){
+    heapset(rq, i, rq->heap[(i-1)/2]);
+    i = (i-1)/2;
+  }
+  heapset(rq, i, p);
+}
+
+// Move the entry at i towards the leaves until both children have
+// a larger pass.
+static void
+heapdown(struct runq *rq, int i)
+{
+  struct proc *p = rq->heap[i];
+  int c;
+
+  while((c = 2*i + 1) < rq->nheap){
+    if(c+1 < rq->nheap && VLT(rq->heap[c+1]->pass, rq->heap[c]->pass))
+      c++;
+    if(!VLT(rq->heap[c]->pass, p->pass))
+      break;
+    heapset(rq, i, rq->heap[c]);
+    i = c;
+  }
+  heapset(rq, i, p);
+}
+static void
+strideenqueue(struct runq *rq, struct proc *p)
+{
+  // Don't let a process bank the passes it missed while asleep.
+  if(VLT(p->pass, rq->minpass))
+    p->pass = rq->minpass;
+  heapset(rq, rq->nheap, p);
+  heapup(rq, rq->nheap++);
+}
+
+static void
+stridedequeue(struct runq *rq, struct proc *p)
+{
+  struct proc *last = rq->heap[--rq->nheap];
+
+  // Fill p's slot with the last entry and sift that either way.
+  if(last != p){
+    heapset(rq, p->heapidx, last);
+    heapup(rq, last->heapidx);
+    heapdown(rq, last->heapidx);
+  }
+  p->heapidx = -1;
+  if(VLT(rq->minpass, p->pass))
+    rq->minpass = p->pass;
+}
+
+static struct proc*
+stridepick(struct runq *rq)
+{
+  return rq->nheap ? rq->heap[0] : 0;
+}
+
+static int
+stridetick(struct runq *rq, struct proc *p)
+{
+  p->pass += STRIDE1 / p->tickets;
+  return rq->nheap > 0 && VLT(rq->heap[0]->pass, p->pass);
+}
+
+static int
+stridepreempt(struct runq *rq, struct proc *p, struct proc *q)
+{
+  return VLT(p->pass, q->pass);
+}
+
+// The process with the largest pass that may run on cpu.  The heap
+// only orders parents before children, so every entry is a candidate.
+static struct proc*
+stridetail(struct runq *rq, int cpu)
+{
+  struct proc *p, *best = 0;
+  int i;
+
+  for(i = 0; i < rq->nheap; i++){
+    p = rq->heap[i];
+    if((p->cpumask & (1 << cpu)) && (best == 0 || VLT(best->pass, p->pass)))
+      best = p;
+  }
+  return best;
+}
+
+//PAGEBREAK!
+// Real-time processes: earliest deadline first, each limited to
+// rtbudget ticks in every period of rtperiod ticks.  They are
+// linked through rqnext/rqprev, which the policies never use for
+// them.  There are few of them, so the pick just scans the list.
+
+// Start p's next period if its deadline has passed.  A process
+// that has been asleep for more than a period starts afresh from
+// now rather than catching up.
+static void
+rtrefill(struct proc *p)
+{
+  if(VLT(ticks, p->deadline))
+    return;
+  if(ticks - p->deadline >= p->rtperiod)
+    p->deadline = ticks + p->rtperiod;
+  else
+    p->deadline += p->rtperiod;
+  p->rtleft = p->rtbudget;
+}
+
+static void
+rtenqueue(struct runq *rq, struct proc *p)
+{
+  p->rqprev = 0;
+  p->rqnext = rq->rthead;
+  if(rq->rthead)
+    rq->rthead->rqprev = p;
+  rq->rthead = p;
+}
+
+static void
+rtdequeue(struct runq *rq, struct proc *p)
+{
+  if(p->rqprev)
+    p->rqprev->rqnext = p->rqnext;
+  else
+    rq->rthead = p->rqnext;
+  if(p->rqnext)
+    p->rqnext->rqprev = p->rqprev;
+  p->rqnext = p->rqprev = 0;
+}
+
+// rtrefill() for p, which is on rq's real-time list, keeping
+// rq->nthrottled in step.
+static void
+rtqrefill(struct runq *rq, struct proc *p)
+{
+  int throttled = p->rtleft <= 0;
+
+  rtrefill(p);
+  if(throttled && p->rtleft > 0)
+    rq->nthrottled--;
+}
+
+// The real-time process with budget left and the earliest
+// deadline, or 0.  Throttled processes stay on the list until
+// their next period starts.
+static struct proc*
+rtpick(struct runq *rq)
+{
+  struct proc *p, *best = 0;
+
+  for(p = rq->rthead; p; p = p->rqnext){
+    rtqrefill(rq, p);
+    if(p->rtleft > 0 && (best == 0 || VLT(p->deadline, best->deadline)))
+      best = p;
+  }
+  return best;
+}
+
+static struct schedpolicy policies[NSCHED] = {
+[SCHED_RR]     { "RR",     fifoenqueue,   fifodequeue,   rrpick,     rrtick,
+                 nopreempt,     fifotail },
+[SCHED_FCFS]   { "FCFS",   fifoenqueue,   fifodequeue,   fcfspick,   fcfstick,
+                 nopreempt,     fifotail },
+[SCHED_PBS]    { "PBS",    fifoenqueue,   fifodequeue,   pbspick,    rrtick,
+                 pbspreempt,    fifotail },
+[SCHED_MLFQ]   { "MLFQ",   mlfqenqueue,   mlfqdequeue,   mlfqpick,   mlfqtick,
+                 mlfqpreempt,   fifotail },
+[SCHED_CFS]    { "CFS",    cfsenqueue,    cfsdequeue,    cfspick,    cfstick,
+                 cfspreempt,    cfstail },
+[SCHED_STRIDE] { "STRIDE", strideenqueue, stridedequeue, stridepick, stridetick,
+                 stridepreempt, stridetail },
+};
+
+//PAGEBREAK!
+// Wake an idle CPU to run p, just queued on p->cpu: p->cpu itself
+// if it is idle, otherwise any other idle CPU in p's mask, which
+// will steal p.  Clearing the idle flag first means each idle spell
+// gets at most one IPI.  The CPU running this is awake already.
+// Returns 1 if it woke a CPU.
+static int
+rqkick(struct proc *p)
+{
+  int i, self, cpu = p->cpu;
+
+  self = cpuid();
+  if(cpu != self && xchg(&cpus[cpu].idle, 0)){
+    lapicipi(cpus[cpu].apicid, T_RESCHED);
+    return 1;
+  }
+  for(i = 0; i < ncpu; i++){
+    if(i != self && i != cpu && (p->cpumask & (1 << i)) &&
+       xchg(&cpus[i].idle, 0)){
+      lapicipi(cpus[i].apicid, T_RESCHED);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Should p, just queued on rq, preempt q, the process running on
+// rq's CPU?  A real-time process with budget left outranks an
+// ordinary one and one with a later deadline.  Between ordinary
+// processes the policy decides.  Caller must hold rq->lock.
+static int
+rqoutranks(struct runq *rq, struct proc *p, struct proc *q)
+{
+  if(q == 0 || q == p)
+    return 0;
+  if(p->rtperiod){
+    rtqrefill(rq, p);
+    return p->rtleft > 0 &&
+           (q->rtperiod == 0 || VLT(p->deadline, q->deadline));
+  }
+  if(q->rtperiod)
+    return 0;
+  return policy->preempt(rq, p, q);
+}
+
+// Move p's lag on the virtual clocks from its queue to cpu's, and
+// make cpu its CPU.
+static void
+rqmove(struct proc *p, int cpu)
+{
+  if(p->cpu >= 0 && p->cpu != cpu){
+    p->vruntime += runq[cpu].min_vruntime - runq[p->cpu].min_vruntime;
+    p->pass += runq[cpu].minpass - runq[p->cpu].minpass;
+  }
+  p->cpu = cpu;
+}
+
+// The CPU whose queue p should join when it may not, or has never,
+// run on p->cpu: the current CPU if p's mask allows, otherwise the
+// CPU in the mask with the shortest queue.
+static int
+rqplace(struct proc *p)
+{
+  int i, best;
+
+  if(p->cpumask & (1 << cpuid()))
+    return cpuid();
+  best = -1;
+  for(i = 0; i < ncpu; i++)
+    if((p->cpumask & (1 << i)) &&
+       (best < 0 || runq[i].nrunnable < runq[best].nrunnable))
+      best = i;
+  if(best < 0)
+    panic("rqplace: empty cpumask");
+  return best;
+}
+
+// Make the process running on cpu yield at its next trap exit,
+// with an IPI if cpu is another CPU.
+void
+rqpreempt(int cpu)
+{
+  cpus[cpu].resched = 1;
+  if(cpu != cpuid())
+    lapicipi(cpus[cpu].apicid, T_RESCHED);
+}
+
+// Add p to rq.  Caller must hold rq->lock.
+static void
+rqinsert(struct runq *rq, struct proc *p)
+{
+  if(p->rtperiod){
+    rtrefill(p);
+    rtenqueue(rq, p);
+    if(p->rtleft <= 0)
+      rq->nthrottled++;
+  } else
+    policy->enqueue(rq, p);
+  rq->nrunnable++;
+}
+
+// Put p, which has just become RUNNABLE, on the run queue of the
+// CPU it last ran on, unless p's mask no longer allows that CPU.
+// A process that has never run goes on the queue of the current
+// CPU, mask permitting.  If no idle CPU can take p and p
+// outranks the process running on its CPU, set that CPU's resched
+// flag, with an IPI if it is another CPU, so that trap() yields on
+// the way out instead of at the next tick.  Caller must hold
+// p->lock.  The process running on p's CPU may change meanwhile,
+// in which case the preemption is stale; it costs at most an
+// extra trip through the scheduler, or a tick of delay.
+void
+rqenqueue(struct proc *p)
+{
+  struct runq *rq;
+  struct cpu *c;
+  int preempt;
+
+  if(p->cpu < 0 || (p->cpumask & (1 << p->cpu)) == 0)
+    rqmove(p, rqplace(p));
+  rq = &runq[p->cpu];
+  c = &cpus[p->cpu];
+
+  acquire(&rq->lock);
+  p->reset_ticks = ticks;
+  rqinsert(rq, p);
+  preempt = rqoutranks(rq, p, c->proc);
+  release(&rq->lock);
+
+  if(!rqkick(p) && preempt)
+    rqpreempt(p->cpu);
+}
+
+// Has rqenqueue() asked the process running on this CPU to yield?
+// Clears the request.
+int
+rqresched(void)
+{
+  int r;
+
+  pushcli();
+  r = xchg(&mycpu()->resched, 0);
+  popcli();
+  return r;
+}
+
+// Take p off rq.  Caller must hold rq->lock.
+static void
+rqremove(struct runq *rq, struct proc *p)
+{
+  if(p->rtperiod){
+    if(p->rtleft <= 0)
+      rq->nthrottled--;
+    rtdequeue(rq, p);
+  } else
+    policy->dequeue(rq, p);
+  rq->nrunnable--;
+}
+
+// The process rq should run next: a real-time one if any can
+// run, and otherwise the policy's choice.  Caller must hold
+// rq->lock.
+static struct proc*
+rqchoose(struct runq *rq)
+{
+  struct proc *p;
+
+  if((p = rtpick(rq)) != 0)
+    return p;
+  return policy->pick(rq);
+}
+
+// Take the process the policy would run next off the busiest other
+// queue, for cpu to run.  If cpu is not in that process's mask, try
+// the next busiest queue.  Returns 0 if there is nothing cpu may
+// take.  p->cpu still names the queue p came from; the caller
+// changes it with rqclaim() once it holds p->lock.
+static struct proc*
+rqsteal(int cpu)
+{
+  struct runq *busiest;
+  struct proc *p;
+  uint tried;
+  int i, n;
+
+  tried = 1 << cpu;
+  for(;;){
+    // The lengths are read without their locks; a stale value only
+    // means we look at the wrong queue and find it empty.  Throttled
+    // real-time processes cannot run, so they do not count.
+    busiest = 0;
+    n = 0;
+    for(i = 0; i < ncpu; i++){
+      if((tried & (1 << i)) == 0 &&
+         runq[i].nrunnable - runq[i].nthrottled > n){
+        n = runq[i].nrunnable - runq[i].nthrottled;
+        busiest = &runq[i];
+      }
+    }
+    if(busiest == 0)
+      return 0;
+    tried |= 1 << (busiest - runq);
+
+    acquire(&busiest->lock);
+    if((p = rqchoose(busiest)) != 0 && (p->cpumask & (1 << cpu))){
+      rqremove(busiest, p);
+      release(&busiest->lock);
+      return p;
+    }
+    release(&busiest->lock);
+  }
+}
+
+// Remove and return the next process for cpu to run, taking it
+// from the local queue if possible and stealing otherwise.
+// Returns 0 if there is nothing to run anywhere.  The caller must
+// call rqclaim() once it holds the process's lock.
+struct proc*
+rqpick(int cpu)
+{
+  struct runq *rq = &runq[cpu];
+  struct proc *p = 0;
+
+  if(rq->nrunnable > 0){
+    acquire(&rq->lock);
+    if((p = rqchoose(rq)) != 0)
+      rqremove(rq, p);
+    release(&rq->lock);
+  }
+  if(p == 0 && (p = rqsteal(cpu)) != 0)
+    rq->nsteal++;
+  return p;
+}
+
+// Make cpu the CPU of p, which rqpick() has just returned to cpu's
+// scheduler.  If p was stolen, keep its lag on the virtual clocks
+// relative to the queue it moves to.  Caller must hold p->lock.
+void
+rqclaim(struct proc *p, int cpu)
+{
+  rqmove(p, cpu);
+}
+
+// Processes queued on or running on cpu.
+static int
+rqnload(int cpu)
+{
+  return runq[cpu].nrunnable + (cpus[cpu].proc != 0);
+}
+
+// Pull a process to cpu from the CPU with the highest load average,
+// if that is at least IMBALANCE above cpu's.  The averages lag, so
+// the move is only made if that CPU also has at least two processes
+// more than cpu right now; otherwise the imbalance would just move.
+// Processes otherwise stay on the CPU they last ran on, where their
+// cache is warm.  The one taken is the one the busy queue would run
+// last, among those whose mask allows cpu: it has the longest wait
+// ahead of it there, and it is never a real-time process or one on
+// a high MLFQ level.  Once off busiest's queue, p is on no queue,
+// so no other CPU can find it; only then is p->lock taken, in the
+// documented order, to move it.  It joins cpu's queue through
+// rqenqueue(), as a woken process would, and so preempts the
+// process running on cpu if it outranks it.  rqbalance() runs in
+// the timer interrupt, so this CPU holds no other lock.
+static void
+rqbalance(int cpu)
+{
+  struct runq *rq = &runq[cpu], *busiest;
+  struct proc *p;
+  int i;
+
+  // As in rqsteal(), the loads are read without locks.
+  busiest = 0;
+  for(i = 0; i < ncpu; i++)
+    if(i != cpu && (busiest == 0 || runq[i].load > busiest->load))
+      busiest = &runq[i];
+  if(busiest == 0 || busiest->load < rq->load + IMBALANCE ||
+     busiest->nrunnable == 0 || rqnload(busiest - runq) < rqnload(cpu) + 2)
+    return;
+
+  acquire(&busiest->lock);
+  if((p = policy->tail(busiest, cpu)) != 0)
+    rqremove(busiest, p);
+  release(&busiest->lock);
+  if(p == 0)
+    return;
+
+  // A process yielding on another CPU holds p->lock until it has
+  // switched away.
+  acquire(&p->lock);
+  rqmove(p, cpu);
+  rqenqueue(p);
+  release(&p->lock);
+  rq->npull++;
+}
+
+// Called by trap() on every timer tick on cpu.  Fold the number of
+// processes queued on or running on cpu into its load average,
+// which forgets a quarter of its past each tick, and every BALANCE
+// ticks see whether another CPU has too much more to do.
+void
+rqtimer(int cpu)
+{
+  struct runq *rq = &runq[cpu];
+
+  rq->load = (3 * rq->load + rqnload(cpu) * LOADSCALE + 2) / 4;
+  if(BALANCE > 0 && ++rq->nticks % BALANCE == 0)
+    rqbalance(cpu);
+}
+
+// Called by cpu's scheduler when rqpick() finds nothing to run.
+// Halt until the next interrupt unless a process has been queued on
+// cpu since.  The idle flag is set before the queue is checked, and
+// rqenqueue() makes a process visible before it checks the flag, so
+// either this sees the new process or rqkick() sees the flag and
+// sends an IPI, as it also does for a process queued elsewhere that
+// may run here.  Other queues are not checked: if their processes
+// are all barred from cpu by their masks, the CPU would only spin
+// in rqsteal().  Any other work is found on the next timer tick.
+// Throttled real-time processes are not work either: once a period
+// starts, rqpick() finds the process through rtpick().
+void
+rqidle(int cpu)
+{
+  struct cpu *c = &cpus[cpu];
+
+  cli();
+  xchg(&c->idle, 1);
+  if(runq[cpu].nrunnable == runq[cpu].nthrottled)
+    stihlt();
+  c->idle = 0;
+  sti();
+}
+
+// Record that cpu has dispatched a process that was RUNNABLE for
+// the given number of cycles.  Bucket i counts waits of 2^i to
+// 2^(i+1)-1 microseconds; bucket 0 also counts waits under 1 us.
+// Waits too long for 32 bits go in the last bucket.  Only cpu
+// itself updates its histograms, so no lock is needed.
+void
+rqlatency(int cpu, uint64 cycles)
+{
+  uint64 us64 = cycles2us(cycles);
+  uint us = us64 > 0xFFFFFFFF ? 0xFFFFFFFF : us64;
+
+  runq[cpu].lat[getscheduler()][us ? 31 - __builtin_clz(us) : 0]++;
+}
+
+// Charge a timer tick to the running process p under the current
+// policy.  Returns 1 if p should give up the CPU.  A real-time
+// process instead uses up a tick of its budget, and is throttled
+// once the budget is gone.
+int
+schedtick(struct proc *p)
+{
+  struct runq *rq = &runq[p->cpu];
+  struct proc *q;
+  int r;
+
+  acquire(&rq->lock);
+  if(p->rtperiod){
+    p->rtleft--;
+    rtrefill(p);
+    r = p->rtleft <= 0;
+  } else
+    r = policy->tick(rq, p);
+
+  // A waiting real-time process with an earlier deadline preempts.
+  if(!r && (q = rtpick(rq)) != 0 &&
+     (p->rtperiod == 0 || VLT(q->deadline, p->deadline)))
+    r = 1;
+  release(&rq->lock);
+  return r;
+}
+
+// The current scheduling policy, one of the SCHED_ constants.
+int
+getscheduler(void)
+{
+  return policy - policies;
+}
+
+// Switch to scheduling policy id and return the previous one, or
+// return -1 if id is not a policy.  Every run queue is locked while
+// its processes are moved from the old policy's structures to the
+// new one's, so no CPU picks in between.
+int
+setscheduler(int id)
+{
+  struct runq *rq;
+  struct proc *p, *moved, **end;
+  int i, old;
+
+  if(id < 0 || id >= NSCHED)
+    return -1;
+
+  for(i = 0; i < NCPU; i++)
+    acquire(&runq[i].lock);
+
+  old = getscheduler();
+  for(i = 0; i < NCPU; i++){
+    rq = &runq[i];
+
+    // Drain the queue in the order the old policy would have run
+    // it, chaining the processes through rqnext.
+    end = &moved;
+    while((p = policy->pick(rq)) != 0){
+      policy->dequeue(rq, p);
+      *end = p;
+      end = &p->rqnext;
+    }
+    *end = 0;
+
+    // Requeue them in that order.  Each joins its new level now,
+    // as far as MLFQ aging is concerned, so every level stays in
+    // arrival order.
+    while((p = moved) != 0){
+      moved = p->rqnext;
+      p->reset_ticks = ticks;
+      policies[id].enqueue(rq, p);
+    }
+  }
+  policy = &policies[id];
+
+  for(i = NCPU - 1; i >= 0; i--)
+    release(&runq[i].lock);
+  return old;
+}
+
+// Change the MLFQ settings to *new, unless new is 0, and copy the
+// settings in force before into *old, unless old is 0.  Returns -1
+// if *new is out of range.  Every run queue is locked, as in
+// setscheduler(), so no CPU sees half the change.  Processes queued
+// on levels that are no longer in use move to the lowest level left,
+// and join it now, as far as aging is concerned.
+int
+setmlfq(struct mlfqparam *new, struct mlfqparam *old)
+{
+  struct runq *rq;
+  struct proc *p;
+  int i, l;
+
+  if(new){
+    if(new->nlevels < 1 || new->nlevels > MAXQUEUE ||
+       new->age < 0 || new->boost < 0)
+      return -1;
+    for(l = 0; l < new->nlevels; l++)
+      if(new->quantum[l] < 1)
+        return -1;
+  }
+
+  for(i = 0; i < NCPU; i++)
+    acquire(&runq[i].lock);
+
+  if(old)
+    *old = mlfq;
+  if(new){
+    mlfq = *new;
+    for(l = mlfq.nlevels; l < MAXQUEUE; l++)
+      mlfq.quantum[l] = mlfq.quantum[mlfq.nlevels - 1];
+    for(i = 0; i < NCPU; i++){
+      rq = &runq[i];
+      for(l = mlfq.nlevels; l < MAXQUEUE; l++){
+        while((p = rq->head[l]) != 0){
+          listremove(rq, p, l);
+          p->cur_queue = mlfq.nlevels - 1;
+          p->reset_ticks = ticks;
+          listpush(rq, p, p->cur_queue);
+        }
+      }
+    }
+  }
+
+  for(i = NCPU - 1; i >= 0; i--)
+    release(&runq[i].lock);
+  return 0;
+}
+
+// Name of scheduling policy id.
+char*
+schedname(int id)
+{
+  if(id < 0 || id >= NSCHED)
+    return "???";
+  return policies[id].name;
+}
+
+// Copy the tick counts, load averages and migration counts of up
+// to n CPUs into cs.  Returns the number of CPUs copied.
+int
+getcpustat(struct cpustat *cs, int n)
+{
+  int i;
+
+  for(i = 0; i < n && i < ncpu; i++){
+    cs[i].cpu = i;
+    cs[i].idle = cpus[i].idleticks;
+    cs[i].busy = cpus[i].busyticks;
+    cs[i].load = runq[i].load;
+    cs[i].steals = runq[i].nsteal;
+    cs[i].pulls = runq[i].npull;
+  }
+  return i;
+}
+
+// Copy up to n dispatch latency histograms into sl, one for each
+// CPU and policy, and return the number copied.  If reset is set,
+// clear every histogram afterwards.  The counts are read without
+// locks, so a dispatch that happens meanwhile may be missed.
+int
+getschedlat(struct schedlat *sl, int n, int reset)
+{
+  int cpu, id, k;
+
+  k = 0;
+  for(cpu = 0; cpu < ncpu; cpu++){
+    for(id = 0; id < NSCHED; id++){
+      if(k < n){
+        sl[k].cpu = cpu;
+        sl[k].policy = id;
+        memmove(sl[k].count, runq[cpu].lat[id], sizeof(sl[k].count));
+        k++;
+      }
+      if(reset)
+        memset(runq[cpu].lat[id], 0, sizeof(runq[cpu].lat[id]));
+    }
+  }
+  return k;
+}
@@ -0,0 +1,8 @@
+// Scheduling policies, for setscheduler().
+#define SCHED_RR       0   // Round robin
+#define SCHED_FCFS     1   // First come first served
+#define SCHED_PBS      2   // Priority based
+#define SCHED_MLFQ     3   // Multi-level feedback queue
+#define SCHED_CFS      4   // Completely fair
+#define SCHED_STRIDE   5   // Stride (proportional share)
+#define NSCHED         6
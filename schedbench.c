@@ -0,0 +1,107 @@
+// Context-switch throughput benchmark.
+//
+// Forks pairs of processes that bounce a byte back and forth over
+// two pipes for a fixed number of ticks.  Every round trip puts
+// both processes to sleep and wakes them again, so the total round
+// trip count measures how fast the scheduler can dispatch.
+// Run it with different CPUS= settings and compare the rates.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NPAIRS  4      // default number of ping-pong pairs
+#define NTICKS  500    // default length of the run
+
+// Bounce bytes until the deadline, then report the round trips
+// through the results pipe.
+void
+ping(int out, int in, int res, uint end)
+{
+  int n = 0;
+  char c = 0;
+
+  while(uptime() < end){
+    if(write(out, &c, 1) != 1 || read(in, &c, 1) != 1)
+      break;
+    n++;
+  }
+  write(res, &n, sizeof(n));
+  exit();
+}
+
+// Echo bytes until the pinger closes its end.
+void
+pong(int in, int out)
+{
+  char c;
+
+  while(read(in, &c, 1) == 1)
+    if(write(out, &c, 1) != 1)
+      break;
+  exit();
+}
+
+int
+main(int argc, char *argv[])
+{
+  int npairs, nticks, i, n, total;
+  int res[2], a[2], b[2];
+  uint start, end;
+
+  npairs = argc > 1 ? atoi(argv[1]) : NPAIRS;
+  nticks = argc > 2 ? atoi(argv[2]) : NTICKS;
+  if(npairs <= 0 || nticks <= 0){
+    printf(2, "usage: schedbench [pairs] [ticks]\n");
+    exit();
+  }
+
+  if(pipe(res) < 0){
+    printf(2, "schedbench: pipe failed\n");
+    exit();
+  }
+
+  start = uptime();
+  end = start + nticks;
+  for(i = 0; i < npairs; i++){
+    if(pipe(a) < 0 || pipe(b) < 0){
+      printf(2, "schedbench: pipe failed\n");
+      exit();
+    }
+    if(fork() == 0){
+      close(res[0]);
+      close(a[0]);
+      close(b[1]);
+      ping(a[1], b[0], res[1], end);
+    }
+    if(fork() == 0){
+      close(res[0]);
+      close(res[1]);
+      close(a[1]);
+      close(b[0]);
+      pong(a[0], b[1]);
+    }
+    close(a[0]);
+    close(a[1]);
+    close(b[0]);
+    close(b[1]);
+  }
+  close(res[1]);
+
+  total = 0;
+  for(i = 0; i < npairs; i++){
+    if(read(res[0], &n, sizeof(n)) != sizeof(n))
+      break;
+    total += n;
+  }
+  for(i = 0; i < 2*npairs; i++)
+    wait();
+  end = uptime();
+
+  // Each round trip is two dispatches.
+  printf(1, "schedbench: %d pairs, %d ticks, %d round trips, "
+         "%d switches per 100 ticks\n",
+         npairs, end - start, total,
+         (2 * total * 100) / (end - start > 0 ? end - start : 1));
+  exit();
+}
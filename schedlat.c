@@ -0,0 +1,88 @@
+// Print the scheduler's dispatch latency histograms.
+//
+// schedlat            since boot or the last reset
+// schedlat -r         reset them
+// schedlat <command>  reset them, run the command, and print them
+//
+// The histograms of all CPUs are added up for each policy.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "pstat.h"
+#include "sched.h"
+
+struct schedlat sl[NCPU * NSCHED];
+uint hist[NSCHED][NLATBUCKET];
+
+// Upper bound, in microseconds, of the bucket that holds the
+// given percentile of the n waits in h.
+uint
+percentile(uint *h, uint n, int pct)
+{
+  uint sum = 0;
+  int i;
+
+  for(i = 0; i < NLATBUCKET - 1; i++){
+    sum += h[i];
+    if(sum * 100 >= n * pct)
+      break;
+  }
+  return 1 << (i + 1);
+}
+
+void
+print(void)
+{
+  int n, i, j, last;
+  uint total;
+
+  n = getschedlat(sl, NCPU * NSCHED, 0);
+  for(i = 0; i < n; i++)
+    for(j = 0; j < NLATBUCKET; j++)
+      hist[sl[i].policy][j] += sl[i].count[j];
+
+  for(i = 0; i < NSCHED; i++){
+    total = 0;
+    last = 0;
+    for(j = 0; j < NLATBUCKET; j++){
+      total += hist[i][j];
+      if(hist[i][j])
+        last = j;
+    }
+    if(total == 0)
+      continue;
+    printf(1, "%s: %d dispatches, p50 < %d us, p99 < %d us\n", schednames[i],
+           total, percentile(hist[i], total, 50), percentile(hist[i], total, 99));
+    for(j = 0; j <= last; j++)
+      printf(1, "  %d-%d us \t %d\n", j ? 1 << j : 0, (1 << (j + 1)) - 1, hist[i][j]);
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int pid;
+
+  if(argc == 2 && strcmp(argv[1], "-r") == 0){
+    getschedlat(0, 0, 1);
+    exit();
+  }
+  if(argc > 1){
+    getschedlat(0, 0, 1);
+    pid = fork();
+    if(pid < 0){
+      printf(2, "schedlat: fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      exec(argv[1], argv + 1);
+      printf(2, "schedlat: exec %s failed\n", argv[1]);
+      exit();
+    }
+    wait();
+  }
+  print();
+  exit();
+}
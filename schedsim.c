@@ -0,0 +1,515 @@
+// Scheduler simulator, run on the host.
+//
+// schedsim [-c cpus] [-p policy] [-n procs] [-a gap] [-s seed]
+//          [-w file] [trace]
+//
+// Replays a trace of processes through the kernel's own sched.c,
+// one timer tick at a time, under every policy (or just -p), and
+// prints the mean turnaround, waiting and response times and a
+// fairness index for each.
+//
+// A trace is a text file with one process per line:
+//
+//   arrival priority cpu io cpu io ... cpu
+//
+// The process arrives at tick arrival with the given PBS priority,
+// then alternates between bursts of CPU and of I/O, in ticks, and
+// exits after the last CPU burst.  # starts a comment.  Without a
+// trace file, schedsim makes up -n processes (default 1000) that
+// arrive on average every -a ticks: a mix of CPU-bound processes
+// with a few long bursts and interactive ones with many short
+// bursts.  -w writes the trace out so it can be edited and replayed.
+//
+// The simulation follows scheduler() and trap(): an idle CPU takes
+// a process with rqpick() and rqclaim(), the process runs for a tick, and then
+// schedtick() decides whether it yields.  A process that finishes
+// a CPU burst gives up its CPU without being charged a tick, and is
+// queued again with rqenqueue() when its I/O is done.  If that sets
+// the resched flag of a CPU, the process running there yields before
+// the next tick.  Every CPU then takes its timer tick in rqtimer(),
+// which may balance the load.  Real-time processes and dispatch latency are not
+// simulated.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "types.h"
+#include "param.h"
+#include "mmu.h"
+#include "proc.h"
+#include "sched.h"
+#include "pstat.h"
+
+// sched.c
+void rqinit(void);
+void rqenqueue(struct proc*);
+struct proc* rqpick(int);
+void rqclaim(struct proc*, int);
+int schedtick(struct proc*);
+int setscheduler(int);
+char* schedname(int);
+void rqtimer(int);
+int getcpustat(struct cpustat*, int);
+
+// simstub.c
+extern uint ticks;
+extern int ncpu;
+extern int simcpu;
+extern struct cpu cpus[];
+
+// One process in the trace, and what happened to it.
+struct job {
+  int arrival;
+  int priority;
+  int nburst;      // CPU and I/O bursts; always odd
+  int *burst;
+  int cur;         // Burst running now
+  int left;        // Ticks left in it
+  int wake;        // Tick its I/O finishes
+  int start;       // Tick it first ran, or -1
+  int finish;      // Tick it exited
+  int busy;        // Ticks of CPU and I/O, i.e. its time alone
+};
+
+struct job *jobs;
+struct proc *procs;
+int njob;
+
+// Sleeping jobs, in a min-heap ordered by wake time.
+int *sleepers;
+int nsleeper;
+
+void
+fatal(char *msg)
+{
+  fprintf(stderr, "schedsim: %s\n", msg);
+  exit(1);
+}
+
+//PAGEBREAK!
+// Traces.
+
+static unsigned long seed = 1;
+
+// Uniform in [lo, hi].
+int
+uniform(int lo, int hi)
+{
+  seed = seed * 1103515245 + 12345;
+  return lo + (int)((seed >> 16) % (unsigned long)(hi - lo + 1));
+}
+
+void
+addjob(int arrival, int priority, int nburst, int *burst)
+{
+  static int cap;
+  struct job *j;
+
+  if(njob == cap){
+    cap = cap ? 2 * cap : 64;
+    if((jobs = realloc(jobs, cap * sizeof(*jobs))) == 0)
+      fatal("out of memory");
+  }
+  j = &jobs[njob++];
+  memset(j, 0, sizeof(*j));
+  j->arrival = arrival;
+  j->priority = priority;
+  j->nburst = nburst;
+  if((j->burst = malloc(nburst * sizeof(int))) == 0)
+    fatal("out of memory");
+  memmove(j->burst, burst, nburst * sizeof(int));
+}
+
+// Make up n processes arriving on average every gap ticks.  A
+// third are CPU-bound, the rest interactive.
+void
+synthesize(int n, int gap)
+{
+  int burst[2 * 20 - 1];
+  int i, k, nburst, arrival;
+
+  arrival = 0;
+  for(i = 0; i < n; i++){
+    if(uniform(0, 2) == 0){
+      nburst = 2 * uniform(1, 3) - 1;
+      for(k = 0; k < nburst; k++)
+        burst[k] = k % 2 ? uniform(1, 10) : uniform(20, 200);
+    } else {
+      nburst = 2 * uniform(5, 20) - 1;
+      for(k = 0; k < nburst; k++)
+        burst[k] = k % 2 ? uniform(5, 50) : uniform(1, 5);
+    }
+    addjob(arrival, uniform(40, 80), nburst, burst);
+    arrival += uniform(0, 2 * gap);
+  }
+}
+
+void
+readtrace(char *path)
+{
+  FILE *f;
+  char line[4096], *s, *e;
+  int v[2 + 2 * 1024], n, lineno;
+
+  if((f = fopen(path, "r")) == 0)
+    fatal("cannot open trace");
+  for(lineno = 1; fgets(line, sizeof(line), f); lineno++){
+    if((s = strchr(line, '#')) != 0)
+      *s = 0;
+    n = 0;
+    for(s = line; n < (int)(sizeof(v) / sizeof(v[0])); s = e){
+      v[n] = strtol(s, &e, 10);
+      if(e == s)
+        break;
+      if(v[n] < 0 || (n >= 2 && v[n] == 0 && n % 2 == 0)){
+        fprintf(stderr, "schedsim: %s:%d: bad value\n", path, lineno);
+        exit(1);
+      }
+      n++;
+    }
+    if(n == 0)
+      continue;
+    if(n < 3 || n % 2 == 0){
+      fprintf(stderr, "schedsim: %s:%d: want arrival priority cpu [io cpu]...\n",
+              path, lineno);
+      exit(1);
+    }
+    addjob(v[0], v[1], n - 2, v + 2);
+  }
+  fclose(f);
+}
+
+void
+writetrace(char *path)
+{
+  FILE *f;
+  int i, k;
+
+  if((f = fopen(path, "w")) == 0)
+    fatal("cannot create trace");
+  fprintf(f, "# arrival priority cpu io cpu io ... cpu\n");
+  for(i = 0; i < njob; i++){
+    fprintf(f, "%d %d", jobs[i].arrival, jobs[i].priority);
+    for(k = 0; k < jobs[i].nburst; k++)
+      fprintf(f, " %d", jobs[i].burst[k]);
+    fprintf(f, "\n");
+  }
+  fclose(f);
+}
+
+static int
+byarrival(const void *a, const void *b)
+{
+  return ((struct job*)a)->arrival - ((struct job*)b)->arrival;
+}
+
+//PAGEBREAK!
+// The sleeper heap.
+
+static int
+earlier(int a, int b)
+{
+  return jobs[sleepers[a]].wake < jobs[sleepers[b]].wake;
+}
+
+static void
+swap(int a, int b)
+{
+  int t = sleepers[a];
+
+  sleepers[a] = sleepers[b];
+  sleepers[b] = t;
+}
+
+void
+sleeppush(int j)
+{
+  int i;
+
+  sleepers[i = nsleeper++] = j;
+  for(; i > 0 && earlier(i, (i-1)/2); i = (i-1)/2)
+    swap(i, (i-1)/2);
+}
+
+int
+sleeppop(void)
+{
+  int i, c, j = sleepers[0];
+
+  sleepers[0] = sleepers[--nsleeper];
+  for(i = 0; (c = 2*i + 1) < nsleeper; i = c){
+    if(c+1 < nsleeper && earlier(c+1, c))
+      c++;
+    if(!earlier(c, i))
+      break;
+    swap(i, c);
+  }
+  return j;
+}
+
+//PAGEBREAK!
+// The simulation.
+
+struct result {
+  double turnaround;   // Mean ticks from arrival to exit
+  double waiting;      // Mean ticks spent runnable
+  double response;     // Mean ticks from arrival to first run
+  double fairness;     // Jain's index of time alone / turnaround
+  long dispatches;     // Times a process was given a CPU
+  long migrations;     // Processes stolen or pulled to another CPU
+  int makespan;        // Tick the last process exited
+};
+
+// Make job j runnable again, as wakeup() or fork() would.
+static void
+ready(int j)
+{
+  procs[j].state = RUNNABLE;
+  rqenqueue(&procs[j]);
+}
+
+// Take the process running on CPU c off it.
+static struct proc*
+descheduled(struct proc **running, int c)
+{
+  struct proc *p = running[c];
+
+  running[c] = 0;
+  cpus[c].proc = 0;
+  simcpu = c;
+  return p;
+}
+
+void
+simulate(int policy, int ncpus, struct result *r)
+{
+  struct proc *running[NCPU], *p;
+  struct cpustat cs0[NCPU], cs[NCPU];
+  struct job *j;
+  int c, i, next, nrun, done;
+  double sum, sumsq, x;
+
+  for(i = 0; i < njob; i++){
+    j = &jobs[i];
+    j->cur = 0;
+    j->left = j->burst[0];
+    j->start = -1;
+    j->busy = 0;
+    for(c = 0; c < j->nburst; c++)
+      j->busy += j->burst[c];
+
+    p = &procs[i];
+    memset(p, 0, sizeof(*p));
+    p->pid = i + 1;
+    p->state = EMBRYO;
+    p->priority = j->priority;
+    p->tickets = TICKETS;
+    p->heapidx = -1;
+    p->cpu = -1;
+    p->cpumask = (1 << ncpus) - 1;
+  }
+  // Start from empty run queues: their load averages, virtual
+  // clocks and counters would otherwise carry over from the
+  // policies simulated before this one.
+  rqinit();
+  memset(running, 0, sizeof(running));
+  memset(cpus, 0, NCPU * sizeof(cpus[0]));
+  // rqsteal(), rqbalance() and rqkick() only look at the first
+  // ncpu CPUs; left at 0, no simulated CPU would ever steal.
+  ncpu = ncpus;
+  getcpustat(cs0, ncpus);
+  nsleeper = 0;
+  setscheduler(policy);
+  memset(r, 0, sizeof(*r));
+
+  ticks = 0;
+  next = 0;
+  done = 0;
+  while(done < njob){
+    // New processes, spread over the CPUs as if forked by a parent
+    // on each in turn.
+    for(; next < njob && jobs[next].arrival <= (int)ticks; next++){
+      simcpu = next % ncpus;
+      procs[next].ctime = ticks;
+      ready(next);
+    }
+
+    // Processes whose I/O is done.
+    while(nsleeper > 0 && jobs[sleepers[0]].wake <= (int)ticks)
+      ready(sleeppop());
+
+    // Preemption by the processes just queued.
+    for(c = 0; c < ncpus; c++){
+      if(cpus[c].resched && running[c]){
+        cpus[c].resched = 0;
+        ready(descheduled(running, c) - procs);
+      }
+    }
+
+    // Idle CPUs take the next process.
+    nrun = 0;
+    for(c = 0; c < ncpus; c++){
+      if(running[c] == 0){
+        simcpu = c;
+        if((p = rqpick(c)) != 0){
+          rqclaim(p, c);
+          p->state = RUNNING;
+          p->n_run++;
+          p->reset_ticks = ticks;
+          cpus[c].proc = p;
+          cpus[c].resched = 0;
+          j = &jobs[p - procs];
+          if(j->start < 0)
+            j->start = ticks;
+          running[c] = p;
+          r->dispatches++;
+        }
+      }
+      if(running[c])
+        nrun++;
+    }
+
+    // Nothing to run: skip to the next arrival or wakeup.
+    if(nrun == 0){
+      i = -1;
+      if(next < njob)
+        i = jobs[next].arrival;
+      if(nsleeper > 0 && (i < 0 || jobs[sleepers[0]].wake < i))
+        i = jobs[sleepers[0]].wake;
+      if(i < 0)
+        fatal("no process can run");
+      ticks = i;
+      continue;
+    }
+
+    // Run for a tick, then take the timer interrupt.
+    ticks++;
+    for(c = 0; c < ncpus; c++){
+      if((p = running[c]) == 0)
+        continue;
+      j = &jobs[p - procs];
+      simcpu = c;
+      if(--j->left == 0){
+        descheduled(running, c);
+        if(++j->cur == j->nburst){
+          p->state = ZOMBIE;
+          j->finish = ticks;
+          done++;
+        } else {
+          p->state = SLEEPING;
+          j->wake = ticks + j->burst[j->cur];
+          j->left = j->burst[++j->cur];
+          sleeppush(p - procs);
+        }
+      } else if(schedtick(p)){
+        ready(descheduled(running, c) - procs);
+      }
+    }
+    for(c = 0; c < ncpus; c++){
+      simcpu = c;
+      rqtimer(c);
+    }
+  }
+
+  getcpustat(cs, ncpus);
+  for(c = 0; c < ncpus; c++)
+    r->migrations += cs[c].steals - cs0[c].steals + cs[c].pulls - cs0[c].pulls;
+
+  sum = sumsq = 0;
+  for(i = 0; i < njob; i++){
+    j = &jobs[i];
+    r->turnaround += j->finish - j->arrival;
+    r->waiting += j->finish - j->arrival - j->busy;
+    r->response += j->start - j->arrival;
+    x = (double)j->busy / (j->finish - j->arrival);
+    sum += x;
+    sumsq += x * x;
+    if(j->finish > r->makespan)
+      r->makespan = j->finish;
+  }
+  r->turnaround /= njob;
+  r->waiting /= njob;
+  r->response /= njob;
+  r->fairness = sum * sum / (njob * sumsq);
+}
+
+void
+usage(void)
+{
+  fprintf(stderr, "usage: schedsim [-c cpus] [-p policy] [-n procs] [-a gap] "
+          "[-s seed] [-w file] [trace]\n");
+  exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct result r;
+  char *out = 0;
+  int opt, ncpus = 1, policy = -1, n = 1000, gap = -1, i;
+
+  while((opt = getopt(argc, argv, "c:p:n:a:s:w:")) != -1){
+    switch(opt){
+    case 'c':
+      ncpus = atoi(optarg);
+      break;
+    case 'p':
+      for(policy = 0; policy < NSCHED; policy++)
+        if(strcmp(optarg, schedname(policy)) == 0)
+          break;
+      if(policy == NSCHED)
+        fatal("unknown policy");
+      break;
+    case 'n':
+      n = atoi(optarg);
+      break;
+    case 'a':
+      gap = atoi(optarg);
+      break;
+    case 's':
+      seed = strtoul(optarg, 0, 10);
+      break;
+    case 'w':
+      out = optarg;
+      break;
+    default:
+      usage();
+    }
+  }
+  if(ncpus < 1 || ncpus > NCPU || n < 1 || argc - optind > 1)
+    usage();
+
+  // By default, keep each CPU about 90% busy.
+  if(gap < 0)
+    gap = 110 / ncpus;
+  if(optind < argc)
+    readtrace(argv[optind]);
+  else
+    synthesize(n, gap);
+  if(njob == 0)
+    fatal("empty trace");
+  if(njob > NPROC)
+    fatal("more processes than NPROC");
+  qsort(jobs, njob, sizeof(*jobs), byarrival);
+  if(out)
+    writetrace(out);
+
+  procs = calloc(njob, sizeof(*procs));
+  sleepers = calloc(njob, sizeof(*sleepers));
+  if(procs == 0 || sleepers == 0)
+    fatal("out of memory");
+
+  printf("%d processes, %d CPUs\n", njob, ncpus);
+  printf("policy \t turnaround \t waiting \t response \t fairness \t dispatches \t migrations \t makespan\n");
+  for(i = 0; i < NSCHED; i++){
+    if(policy >= 0 && i != policy)
+      continue;
+    simulate(i, ncpus, &r);
+    printf("%s \t %.1f \t %.1f \t %.1f \t %.3f \t %ld \t %ld \t %d\n",
+           schedname(i), r.turnaround, r.waiting, r.response, r.fairness,
+           r.dispatches, r.migrations, r.makespan);
+  }
+  return 0;
+}
@@ -0,0 +1,56 @@
+// Pin a process to a set of CPUs.
+//
+// setAffinity <cpus> <pid> lets the process run only on the listed
+// CPUs, given as a comma-separated list such as 0,2,3.  A list of
+// "-" leaves the mask alone.  Prints the old and new masks in hex.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+// Parse a list like "0,2,3" into a CPU mask, or return 0.
+uint
+parse(char *s)
+{
+  uint mask = 0;
+  int n;
+
+  if(strcmp(s, "-") == 0)
+    return 0;
+  while(*s){
+    if(*s < '0' || *s > '9')
+      return 0;
+    for(n = 0; *s >= '0' && *s <= '9'; s++)
+      n = n * 10 + *s - '0';
+    if(n >= 32 || (*s != ',' && *s != 0))
+      return 0;
+    mask |= 1 << n;
+    if(*s == ',')
+      s++;
+  }
+  return mask;
+}
+
+int
+main(int argc, char *argv[])
+{
+  uint mask;
+  int pid, old;
+
+  if(argc != 3){
+    printf(2, "usage: setAffinity <cpus|-> <pid>\n");
+    exit();
+  }
+  mask = parse(argv[1]);
+  if(mask == 0 && strcmp(argv[1], "-") != 0){
+    printf(2, "setAffinity: bad cpu list %s\n", argv[1]);
+    exit();
+  }
+  pid = atoi(argv[2]);
+  if((old = setaffinity(pid, mask)) < 0){
+    printf(2, "setAffinity: failed for pid %d\n", pid);
+    exit();
+  }
+  printf(1, "Old: %x\nNew: %x\n", old, setaffinity(pid, 0));
+  exit();
+}
@@ -0,0 +1,34 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "sched.h"
+
+int
+main(int argc, char **argv)
+{
+    int i, old;
+
+    if (argc > 2)
+    {
+        printf(2, "Usage: setScheduler [RR|FCFS|PBS|MLFQ|CFS|STRIDE]\n");
+        exit();
+    }
+    if (argc == 1)
+    {
+        printf(1, "%s\n", schednames[setscheduler(-1)]);
+        exit();
+    }
+
+    for (i = 0; i < NSCHED; i++)
+        if (strcmp(argv[1], schednames[i]) == 0)
+            break;
+    if (i == NSCHED)
+    {
+        printf(2, "setScheduler: unknown policy %s\n", argv[1]);
+        exit();
+    }
+
+    old = setscheduler(i);
+    printf(1, "Old: %s\nNew: %s\n", schednames[old], schednames[i]);
+    exit();
+}
@@ -0,0 +1,77 @@
+// Stand-ins for the parts of the kernel that sched.c uses, so that
+// sched.c can be linked into schedsim and run on the host.  There
+// is one thread of control, so locks do nothing, and no CPU ever
+// halts in rqidle(), so no IPI is ever sent.
+
+#include <stdio.h>
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "proc.h"
+#include "spinlock.h"
+
+struct cpu cpus[NCPU];
+int ncpu;
+uint ticks;
+int simcpu;      // The CPU schedsim is acting for
+
+int
+cpuid(void)
+{
+  return simcpu;
+}
+
+struct cpu*
+mycpu(void)
+{
+  return &cpus[simcpu];
+}
+
+void
+pushcli(void)
+{
+}
+
+void
+popcli(void)
+{
+}
+
+void
+initlock(struct spinlock *lk, char *name)
+{
+  lk->name = name;
+  lk->locked = 0;
+}
+
+void
+acquire(struct spinlock *lk)
+{
+  lk->locked = 1;
+}
+
+void
+release(struct spinlock *lk)
+{
+  lk->locked = 0;
+}
+
+void
+lapicipi(int apicid, int vector)
+{
+}
+
+void
+panic(char *s)
+{
+  fprintf(stderr, "schedsim: panic: %s\n", s);
+  __builtin_abort();
+}
+
+uint64
+cycles2us(uint64 cycles)
+{
+  return 0;
+}
@@ -17,17 +17,27 @@ initsleeplock(struct sleeplock *lk, char *name)
   lk->name = name;
   lk->locked = 0;
   lk->pid = 0;
+  lk->holder = 0;
+  lk->heldnext = 0;
+  lk->waitpri = 100;
 }
 
 void
 acquiresleep(struct sleeplock *lk)
 {
+  struct proc *p = myproc();
+
   acquire(&lk->lk);
   while (lk->locked) {
+    sleeplockwait(lk);  // lend our priority to the holder
     sleep(lk, &lk->lk);
   }
+  p->waitlock = 0;
   lk->locked = 1;
-  lk->pid = myproc()->pid;
+  lk->pid = p->pid;
+  lk->holder = p;
+  lk->heldnext = p->held;
+  p->held = lk;
   release(&lk->lk);
 }
 
@@ -37,7 +47,7 @@ releasesleep(struct sleeplock *lk)
   acquire(&lk->lk);
   lk->locked = 0;
   lk->pid = 0;
-  wakeup(lk);
+  sleeplockrelease(lk);  // give back lent priority, and wakeup(lk)
   release(&lk->lk);
 }
 
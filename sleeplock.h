@@ -6,5 +6,10 @@ struct sleeplock {
   // For debugging:
   char *name;        // Name of lock.
   int pid;           // Process holding lock
+
+  // For priority inheritance; see sleeplockwait().
+  struct proc *holder;        // Process holding lock
+  struct sleeplock *heldnext; // Next lock the holder holds
+  int waitpri;                // Best priority lent by a waiter; 100 if none
 };
 
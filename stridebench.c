@@ -0,0 +1,79 @@
+// Proportional-share check for the STRIDE policy.
+//
+// A variant of benchmark: forks CPU-bound children holding 1, 2
+// and 3 shares of tickets, lets them compete for a fixed number of
+// ticks, and checks that the CPU time each one got (from waitx)
+// matches its share of the tickets within a tolerance.  It switches
+// to STRIDE for the run and pins the children to CPU 0, so that
+// they all compete for the same CPU, then puts back the policy and
+// mask it found.
+
+#include "types.h"
+#include "user.h"
+#include "sched.h"
+
+#define NCHILD     3
+#define NTICKS     1000     // length of the run
+#define TOLERANCE  5        // allowed error, in percentage points
+
+int tickets[NCHILD] = { 100, 200, 300 };
+
+int
+main(int argc, char *argv[])
+{
+  int pid[NCHILD], rtime[NCHILD];
+  int i, j, p, wtime, rt, total, totaltickets, want, got, fail;
+  int oldsched, oldmask;
+  uint end;
+
+  // Children inherit the mask.
+  oldsched = setscheduler(SCHED_STRIDE);
+  oldmask = setaffinity(getpid(), 1);
+
+  end = uptime() + NTICKS;
+  for(i = 0; i < NCHILD; i++){
+    pid[i] = fork();
+    if(pid[i] < 0){
+      printf(1, "Fork failed\n");
+      break;
+    }
+    if(pid[i] == 0){
+      settickets(tickets[i], getpid());
+      while(uptime() < end)
+        ; //cpu time
+      exit();
+    }
+  }
+
+  total = 0;
+  for(i = 0; i < NCHILD; i++){
+    if((p = waitx(&wtime, &rt)) < 0)
+      break;
+    for(j = 0; j < NCHILD; j++)
+      if(pid[j] == p)
+        rtime[j] = rt;
+    total += rt;
+  }
+  setscheduler(oldsched);
+  setaffinity(getpid(), oldmask);
+  if(i < NCHILD){
+    printf(1, "stridebench: FAIL\n");
+    exit();
+  }
+
+  totaltickets = 0;
+  for(i = 0; i < NCHILD; i++)
+    totaltickets += tickets[i];
+
+  fail = 0;
+  for(i = 0; i < NCHILD; i++){
+    want = tickets[i] * 100 / totaltickets;
+    got = total > 0 ? rtime[i] * 100 / total : 0;
+    if(got < want - TOLERANCE || got > want + TOLERANCE)
+      fail = 1;
+    printf(1, "tickets %d: rtime %d, %d%% of cpu, expected %d%%\n",
+           tickets[i], rtime[i], got, want);
+  }
+  printf(1, "stridebench: %s\n", fail ? "FAIL" : "OK");
+  exit();
+}
@@ -106,6 +106,20 @@ extern int sys_uptime(void);
 extern int sys_waitx(void);
 extern int sys_getps(void);
 extern int sys_set_priority(void);
+extern int sys_settickets(void);
+extern int sys_setscheduler(void);
+extern int sys_wakestat(void);
+extern int sys_getcpustat(void);
+extern int sys_waitstat(void);
+extern int sys_getpinfo(void);
+extern int sys_getschedlat(void);
+extern int sys_setrt(void);
+extern int sys_clone(void);
+extern int sys_join(void);
+extern int sys_futex_wait(void);
+extern int sys_futex_wake(void);
+extern int sys_setmlfq(void);
+extern int sys_setaffinity(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -131,7 +145,21 @@ static int (*syscalls[])(void) = {
 [SYS_close]   sys_close,
 [SYS_waitx]   sys_waitx,
 [SYS_getps]   sys_getps,
-[SYS_set_priority] sys_set_priority
+[SYS_set_priority] sys_set_priority,
+[SYS_settickets] sys_settickets,
+[SYS_setscheduler] sys_setscheduler,
+[SYS_wakestat] sys_wakestat,
+[SYS_getcpustat] sys_getcpustat,
+[SYS_waitstat] sys_waitstat,
+[SYS_getpinfo] sys_getpinfo,
+[SYS_getschedlat] sys_getschedlat,
+[SYS_setrt]   sys_setrt,
+[SYS_clone]   sys_clone,
+[SYS_join]    sys_join,
+[SYS_futex_wait] sys_futex_wait,
+[SYS_futex_wake] sys_futex_wake,
+[SYS_setmlfq] sys_setmlfq,
+[SYS_setaffinity] sys_setaffinity,
 };
 
 void
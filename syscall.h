@@ -22,4 +22,18 @@
 #define SYS_close          21
 #define SYS_waitx          22
 #define SYS_getps          23
-#define SYS_set_priority   24
\ No newline at end of file
+#define SYS_set_priority   24
+#define SYS_settickets     25
+#define SYS_setscheduler   26
+#define SYS_wakestat       27
+#define SYS_getcpustat     28
+#define SYS_waitstat       29
+#define SYS_getpinfo       30
+#define SYS_getschedlat    31
+#define SYS_setrt          32
+#define SYS_clone          33
+#define SYS_join           34
+#define SYS_futex_wait     35
+#define SYS_futex_wake     36
+#define SYS_setmlfq        37
+#define SYS_setaffinity    38
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "proc.h"
+#include "pstat.h"
+#include "sched.h"
 
 int
 sys_fork(void)
@@ -50,8 +52,9 @@ sys_sbrk(void)
 
   if(argint(0, &n) < 0)
     return -1;
-  addr = myproc()->sz;
-  if(growproc(n) < 0)
+  // growproc() returns the old size, read under the same lock
+  // as the resize, so threads calling sbrk() get distinct memory.
+  if((addr = growproc(n)) < 0)
     return -1;
   return addr;
 }
@@ -121,4 +124,193 @@ sys_set_priority(void)
         return -1;
 
     return set_priority(new_priority, pid);
-}
\ No newline at end of file
+}
+
+int
+sys_settickets(void)
+{
+    int tickets, pid;
+
+    if (argint(0, &tickets) < 0)
+        return -1;
+    if (argint(1, &pid) < 0)
+        return -1;
+
+    return settickets(tickets, pid);
+}
+
+// Switch the scheduling policy; a negative policy only
+// returns the current one.
+int
+sys_setscheduler(void)
+{
+    int policy;
+
+    if (argint(0, &policy) < 0)
+        return -1;
+    if (policy < 0)
+        return getscheduler();
+
+    return setscheduler(policy);
+}
+
+int
+sys_wakestat(void)
+{
+    int *wakeups, *scanned;
+
+    if (argptr(0, (void*)&wakeups, sizeof(*wakeups)) < 0)
+        return -1;
+    if (argptr(1, (void*)&scanned, sizeof(*scanned)) < 0)
+        return -1;
+
+    return wakestat(wakeups, scanned);
+}
+
+int
+sys_getcpustat(void)
+{
+    struct cpustat *cs;
+    int n;
+
+    if (argint(1, &n) < 0 || n < 0)
+        return -1;
+    if (n > NCPU)
+        n = NCPU;
+    if (argptr(0, (void*)&cs, n * sizeof(*cs)) < 0)
+        return -1;
+
+    return getcpustat(cs, n);
+}
+
+int
+sys_waitstat(void)
+{
+    struct proctime *pt;
+
+    if (argptr(0, (void*)&pt, sizeof(*pt)) < 0)
+        return -1;
+
+    return waitstat(pt);
+}
+
+int
+sys_getpinfo(void)
+{
+    struct procinfo *pi;
+    int n;
+
+    if (argint(1, &n) < 0 || n < 0)
+        return -1;
+    if (n > NPROC)
+        n = NPROC;
+    if (argptr(0, (void*)&pi, n * sizeof(*pi)) < 0)
+        return -1;
+
+    return getpinfo(pi, n);
+}
+
+int
+sys_getschedlat(void)
+{
+    struct schedlat *sl;
+    int n, reset;
+
+    if (argint(1, &n) < 0 || n < 0 || argint(2, &reset) < 0)
+        return -1;
+    if (n > NCPU * NSCHED)
+        n = NCPU * NSCHED;
+    if (argptr(0, (void*)&sl, n * sizeof(*sl)) < 0)
+        return -1;
+
+    return getschedlat(sl, n, reset);
+}
+
+int
+sys_setrt(void)
+{
+    int period, budget;
+
+    if (argint(0, &period) < 0 || argint(1, &budget) < 0)
+        return -1;
+
+    return setrt(period, budget);
+}
+
+int
+sys_clone(void)
+{
+    int fcn, arg1, arg2, stack;
+
+    if (argint(0, &fcn) < 0 || argint(1, &arg1) < 0)
+        return -1;
+    if (argint(2, &arg2) < 0 || argint(3, &stack) < 0)
+        return -1;
+
+    return clone((void(*)(void*, void*))fcn, (void*)arg1, (void*)arg2, (void*)stack);
+}
+
+int
+sys_join(void)
+{
+    void **stack;
+
+    if (argptr(0, (void*)&stack, sizeof(*stack)) < 0)
+        return -1;
+
+    return join(stack);
+}
+
+int
+sys_futex_wait(void)
+{
+    int addr, val;
+
+    if (argint(0, &addr) < 0 || argint(1, &val) < 0)
+        return -1;
+
+    return futex_wait((int*)addr, val);
+}
+
+int
+sys_futex_wake(void)
+{
+    int addr, n;
+
+    if (argint(0, &addr) < 0 || argint(1, &n) < 0)
+        return -1;
+
+    return futex_wake((int*)addr, n);
+}
+
+// Either pointer may be 0, which is left alone rather than passed
+// to argptr(): address 0 is a valid user address.
+int
+sys_setmlfq(void)
+{
+    struct mlfqparam *new, *old;
+    int a, b;
+
+    if (argint(0, &a) < 0 || argint(1, &b) < 0)
+        return -1;
+    new = old = 0;
+    if (a && argptr(0, (void*)&new, sizeof(*new)) < 0)
+        return -1;
+    if (b && argptr(1, (void*)&old, sizeof(*old)) < 0)
+        return -1;
+
+    return setmlfq(new, old);
+}
+
+int
+sys_setaffinity(void)
+{
+    int pid, mask;
+
+    if (argint(0, &pid) < 0)
+        return -1;
+    if (argint(1, &mask) < 0)
+        return -1;
+
+    return setaffinity(pid, (uint)mask);
+}
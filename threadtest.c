@@ -0,0 +1,91 @@
+// Threads sharing one address space.
+//
+// threadtest [threads] counts the primes below LIMIT, first with
+// one thread and then split across the given number of threads
+// (default 4), and prints both times.  With CPUS= set to at least
+// the number of threads, the second run should be that much faster.
+// The threads write their counts straight into a global array,
+// which only works because they share memory.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NTHREAD  4
+#define MAXTHREAD 16
+#define LIMIT    200000
+
+int count[MAXTHREAD];
+
+int
+isprime(int n)
+{
+  int d;
+
+  if(n < 2)
+    return 0;
+  for(d = 2; d * d <= n; d++)
+    if(n % d == 0)
+      return 0;
+  return 1;
+}
+
+// Thread i of n counts the primes i, i+n, i+2n, ... below LIMIT.
+void
+worker(void *a1, void *a2)
+{
+  int i = (int)a1, n = (int)a2, k;
+
+  count[i] = 0;
+  for(k = i; k < LIMIT; k += n)
+    count[i] += isprime(k);
+  exit();
+}
+
+// Count with n threads and return the number of primes.
+int
+run(int n)
+{
+  int i, total;
+
+  for(i = 0; i < n; i++){
+    if(thread_create(worker, (void*)i, (void*)n) < 0){
+      printf(2, "threadtest: thread_create failed\n");
+      exit();
+    }
+  }
+  for(i = 0; i < n; i++)
+    if(thread_join() < 0){
+      printf(2, "threadtest: thread_join failed\n");
+      exit();
+    }
+
+  total = 0;
+  for(i = 0; i < n; i++)
+    total += count[i];
+  return total;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int n, p1, pn;
+  uint t0, t1, t2;
+
+  n = argc > 1 ? atoi(argv[1]) : NTHREAD;
+  if(n <= 0 || n > MAXTHREAD){
+    printf(2, "usage: threadtest [threads]\n");
+    exit();
+  }
+
+  t0 = uptime();
+  p1 = run(1);
+  t1 = uptime();
+  pn = run(n);
+  t2 = uptime();
+
+  printf(1, "1 thread: %d primes in %d ticks\n", p1, t1 - t0);
+  printf(1, "%d threads: %d primes in %d ticks\n", n, pn, t2 - t1);
+  printf(1, "threadtest: %s\n", p1 == pn ? "OK" : "FAIL");
+  exit();
+}
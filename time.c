@@ -2,10 +2,23 @@
 #include "stat.h"
 #include "user.h"
 #include "fcntl.h"
+#include "param.h"
+#include "pstat.h"
+#include "x86.h"
 
 #define RED "\u001b[31m"
 #define RESET "\u001b[0m"
 
+// Print a 64-bit count of microseconds in milliseconds.  There is
+// no libgcc to divide 64-bit numbers, so use divu64().
+void
+printms(char *name, uint64 us)
+{
+    uint ms = divu64(us, 1000), frac = us - (uint64)ms * 1000;
+
+    printf(1, "%s %d.%d%d%d ms", name, ms, frac / 100, frac / 10 % 10, frac % 10);
+}
+
 int 
 main(int argc, char **argv)
 {
@@ -19,12 +32,15 @@ main(int argc, char **argv)
     }
     else
     {
-        int * rtime = malloc(sizeof(int));
-        int * wtime = malloc(sizeof(int));
-        
-        waitx(wtime, rtime);
-        // returns the clock cycle ticks.
-        printf(1, "Waiting time for the process [pid: %d] = %d\nRunning time for the process [pid: %d] = %d\n", rc, *wtime, rc, *rtime);
+        struct proctime pt;
+
+        waitstat(&pt);
+        // ticks, and microseconds measured with the cycle counter.
+        printf(1, "Waiting time for the process [pid: %d] = %d\nRunning time for the process [pid: %d] = %d\n", rc, pt.wtime, rc, pt.rtime);
+        printms("run", pt.runus);
+        printms(", wait", pt.waitus);
+        printms(", sleep", pt.sleepus);
+        printf(1, "\n");
     }
     exit();
 }
\ No newline at end of file
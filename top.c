@@ -0,0 +1,79 @@
+// Live process monitor.
+//
+// top [interval] [count] samples the process table every interval
+// ticks (default 100), count times (default 10), and prints each
+// process's share of a CPU over the last interval, busiest first.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "pstat.h"
+
+#define INTERVAL  100
+#define COUNT     10
+
+char *states[] = { "unused", "embryo", "sleep", "runble", "run", "zombie" };
+
+struct procinfo prev[NPROC], cur[NPROC];
+int cpu[NPROC];     // CPU% of cur[i] over the last interval
+int order[NPROC];   // Indices into cur, busiest first
+
+// rtime of pid in the previous sample, or 0 if it is new.
+int
+prevrtime(int nprev, int pid)
+{
+  int i;
+
+  for(i = 0; i < nprev; i++)
+    if(prev[i].pid == pid)
+      return prev[i].rtime;
+  return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int interval, count, nprev, n, i, j, k, t;
+  uint t0, t1;
+
+  interval = argc > 1 ? atoi(argv[1]) : INTERVAL;
+  count = argc > 2 ? atoi(argv[2]) : COUNT;
+  if(interval <= 0 || count <= 0){
+    printf(2, "usage: top [interval] [count]\n");
+    exit();
+  }
+
+  nprev = getpinfo(prev, NPROC);
+  t0 = uptime();
+  while(count-- > 0){
+    sleep(interval);
+    n = getpinfo(cur, NPROC);
+    t1 = uptime();
+    t = t1 - t0 > 0 ? t1 - t0 : 1;
+
+    // CPU% is run ticks over elapsed ticks, so a process that
+    // keeps one CPU busy shows 100.
+    for(i = 0; i < n; i++){
+      cpu[i] = (cur[i].rtime - prevrtime(nprev, cur[i].pid)) * 100 / t;
+      // Insertion sort on cpu.
+      for(j = i; j > 0 && cpu[order[j-1]] < cpu[i]; j--)
+        order[j] = order[j-1];
+      order[j] = i;
+    }
+
+    printf(1, "\nuptime %d, %d processes\n", t1, n);
+    printf(1, "PID \t CPU%% \t STATE \t PRIO \t Q \t RTIME \t SIZE \t NAME\n");
+    for(i = 0; i < n; i++){
+      k = order[i];
+      printf(1, "%d \t %d \t %s \t %d \t %d \t %d \t %d \t %s\n",
+             cur[k].pid, cpu[k], states[cur[k].state], cur[k].priority,
+             cur[k].queue, cur[k].rtime, cur[k].sz, cur[k].name);
+    }
+
+    memmove(prev, cur, n * sizeof(cur[0]));
+    nprev = n;
+    t0 = t1;
+  }
+  exit();
+}
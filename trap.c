@@ -36,6 +36,8 @@ idtinit(void)
 void
 trap(struct trapframe *tf)
 {
+  int resched;
+
   if(tf->trapno == T_SYSCALL){
     if(myproc()->killed)
       exit();
@@ -43,6 +45,9 @@ trap(struct trapframe *tf)
     syscall();
     if(myproc()->killed)
       exit();
+    // The system call may have woken a process that outranks us.
+    if(rqresched())
+      yield();
     return;
   }
 
@@ -51,19 +56,22 @@ trap(struct trapframe *tf)
     if(cpuid() == 0){
       acquire(&tickslock);
       ticks++;
-      #ifdef MLFQ
-        ageproc();
-      #endif
       wakeup(&ticks);
       release(&tickslock);
     }
-    if (myproc())
-    {
-        if (myproc()->state == RUNNING)
-            myproc()->rtime += 1;
-        else if (myproc()->state == SLEEPING)
-            myproc()->iotime += 1;
-    }
+    if(mycpu()->proc)
+      mycpu()->busyticks++;
+    else
+      mycpu()->idleticks++;
+    rqtimer(cpuid());
+    // Sleep time is charged when a process wakes up; see setstate().
+    if (myproc() && myproc()->state == RUNNING)
+        myproc()->rtime += 1;
+    lapiceoi();
+    break;
+  case T_RESCHED:
+    // Wakes the CPU from hlt in rqidle(), or has the running
+    // process yield below; see rqenqueue().
     lapiceoi();
     break;
   case T_IRQ0 + IRQ_IDE:
@@ -110,38 +118,22 @@ trap(struct trapframe *tf)
   if(myproc() && myproc()->killed && (tf->cs&3) == DPL_USER)
     exit();
 
-  #ifdef MLFQ
-       // Check the waiting times and push the respective processes down the queue
-    struct proc * p = myproc();
-    if(p && tf->trapno == T_IRQ0 + IRQ_TIMER 
-            && p->state == RUNNING) {
-        p->ticks[p->queue]++;
-
-        if(ticks - p->reset_ticks >= (1 << p->queue)) {
-            yield();
-            int newQ = p->queue + 1;
-            if (p->queue >= NUMQUEUE)
-                newQ = NUMQUEUE - 1;
-            struct proc * del = mlfq[p->queue].q[q->beg];
-            deletefront(&mlfq[p->queue]);
-            del->queue = newQ;
-            del->reset_ticks = ticks;
-            pushback(&mlfq[nextQ], del);
-        }
-    }
-  #endif
-
-  // no preemption in FCFS
-  #ifndef FCFS
-  #ifndef MLFQ
-  // Force process to give up CPU on clock tick.
+  // Charge the clock tick to the running process.  The scheduling
+  // policy decides whether it should give up the CPU; under FCFS it
+  // only has to for a real-time process.  A real-time process is
+  // throttled here once it has used up its budget.  The process also
+  // yields at once, tick or not, if a process that outranks it has
+  // been queued on this CPU since the last trap.
   // If interrupts were on while locks held, would need to check nlock.
-  if(myproc() && myproc()->state == RUNNING &&
-     tf->trapno == T_IRQ0+IRQ_TIMER)
-    yield();
-  #endif
+  if(myproc() && myproc()->state == RUNNING){
+    resched = rqresched();
+    if(tf->trapno == T_IRQ0+IRQ_TIMER && schedtick(myproc()))
+      resched = 1;
+    if(resched)
+      yield();
+  }
+
   // Check if the process has been killed since we yielded
   if(myproc() && myproc()->killed && (tf->cs&3) == DPL_USER)
     exit();
-  #endif
 }
\ No newline at end of file
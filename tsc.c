@@ -0,0 +1,52 @@
+// Time stamp counter.
+//
+// The TSC counts CPU cycles.  tscinit() measures how many it
+// counts per microsecond against channel 2 of the 8253 PIT,
+// whose input clock runs at a fixed 1193182 Hz.
+
+#include "types.h"
+#include "defs.h"
+#include "x86.h"
+
+#define PIT_HZ      1193182
+#define PIT_CH2     0x42        // Channel 2 data port
+#define PIT_MODE    0x43        // Mode/command register
+#define PIT_GATE    0x61        // Channel 2 gate and output
+  #define GATE2     0x01        // Channel 2 counts while set
+  #define SPEAKER   0x02        // Connect channel 2 to the speaker
+  #define OUT2      0x20        // Channel 2 output
+
+#define CALMS       10          // Length of the calibration, in ms
+
+uint tscmhz;  // TSC cycles per microsecond
+
+void
+tscinit(void)
+{
+  uint latch = PIT_HZ / (1000 / CALMS);
+  uint64 t0, t1;
+
+  // Count channel 2 down once in mode 0 (interrupt on terminal
+  // count) with the speaker off, and time it with the TSC.
+  outb(PIT_GATE, (inb(PIT_GATE) & ~SPEAKER) | GATE2);
+  outb(PIT_MODE, 0xB0);  // channel 2, low then high byte, mode 0
+  outb(PIT_CH2, latch & 0xFF);
+  outb(PIT_CH2, latch >> 8);
+  t0 = rdtsc();
+  while((inb(PIT_GATE) & OUT2) == 0)
+    ;
+  t1 = rdtsc();
+
+  tscmhz = divu64(t1 - t0, CALMS * 1000);
+  if(tscmhz == 0)
+    tscmhz = 1;
+  cprintf("tsc: %d MHz\n", tscmhz);
+}
+
+// Convert a number of TSC cycles to microseconds.  The result is
+// 64 bits wide: 32 bits of microseconds only last 71 minutes.
+uint64
+cycles2us(uint64 cycles)
+{
+  return divu64(cycles, tscmhz);
+}
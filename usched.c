@@ -0,0 +1,42 @@
+// Helpers shared by the scheduler benchmarks.
+
+#include "types.h"
+#include "user.h"
+#include "sched.h"
+
+// Policy names, indexed by SCHED_*, as setscheduler() numbers them.
+char *schednames[NSCHED] = {
+[SCHED_RR]      "RR",
+[SCHED_FCFS]    "FCFS",
+[SCHED_PBS]     "PBS",
+[SCHED_MLFQ]    "MLFQ",
+[SCHED_CFS]     "CFS",
+[SCHED_STRIDE]  "STRIDE",
+};
+
+// Burn CPU for n loop iterations, without touching memory that
+// another process could share.
+void
+spin(int n)
+{
+  volatile int x = 0;
+
+  while(n-- > 0)
+    x++;
+}
+
+// Count spin() iterations in one whole tick.
+int
+calibrate(void)
+{
+  uint t;
+  int n;
+
+  t = uptime();
+  while(uptime() == t)
+    ;
+  t = uptime();
+  for(n = 0; uptime() == t; n += 1000)
+    spin(1000);
+  return n;
+}
@@ -1,5 +1,10 @@
 struct stat;
 struct rtcdate;
+struct cpustat;
+struct proctime;
+struct procinfo;
+struct schedlat;
+struct mlfqparam;
 
 // system calls
 int fork(void);
@@ -26,6 +31,20 @@ int uptime(void);
 int waitx(int*, int*);
 int getps(void);
 int set_priority(int, int);
+int settickets(int, int);
+int setscheduler(int);
+int wakestat(int*, int*);
+int getcpustat(struct cpustat*, int);
+int waitstat(struct proctime*);
+int getpinfo(struct procinfo*, int);
+int getschedlat(struct schedlat*, int, int);
+int setrt(int, int);
+int clone(void(*)(void*, void*), void*, void*, void*);
+int join(void**);
+int futex_wait(volatile int*, int);
+int futex_wake(volatile int*, int);
+int setmlfq(struct mlfqparam*, struct mlfqparam*);
+int setaffinity(int, uint);
 
 // ulib.c
 int stat(const char*, struct stat*);
@@ -39,4 +58,29 @@ uint strlen(const char*);
 void* memset(void*, int, uint);
 void* malloc(uint);
 void free(void*);
-int atoi(const char*);
\ No newline at end of file
+int atoi(const char*);
+
+// uthread.c
+typedef struct { volatile uint locked; } lock_t;
+void lock_init(lock_t*);
+void lock_acquire(lock_t*);
+void lock_release(lock_t*);
+int thread_create(void(*)(void*, void*), void*, void*);
+int thread_join(void);
+typedef struct { volatile int state; } mutex_t;
+void mutex_init(mutex_t*);
+void mutex_lock(mutex_t*);
+void mutex_unlock(mutex_t*);
+typedef struct { volatile int seq; } cond_t;
+void cond_init(cond_t*);
+void cond_wait(cond_t*, mutex_t*);
+void cond_signal(cond_t*);
+void cond_broadcast(cond_t*);
+typedef struct { mutex_t m; cond_t c; int n, count, gen; } barrier_t;
+void barrier_init(barrier_t*, int);
+void barrier_wait(barrier_t*);
+
+// usched.c
+extern char *schednames[];
+void spin(int);
+int calibrate(void);
\ No newline at end of file
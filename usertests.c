@@ -7,6 +7,8 @@
 #include "syscall.h"
 #include "traps.h"
 #include "memlayout.h"
+#include "pstat.h"
+#include "sched.h"
 
 char buf[8192];
 char name[3];
@@ -400,6 +402,101 @@ preempt(void)
   printf(1, "preempt ok\n");
 }
 
+// Priority inversion through a sleep lock, under PBS.  A
+// priority-90 process keeps reading a big file, so it usually holds
+// the file's inode lock.  CPU hogs at priority 50 then take every
+// CPU and starve it, wherever it is.  A priority-10 process opens
+// the file, which needs the inode lock.  Unless the reader inherits
+// priority 10 and finishes its read, the open waits until the hogs
+// are killed.
+#define PIBLOCKS  (NDIRECT + NINDIRECT)
+#define PITICKS   100
+
+void
+priorityinherit(void)
+{
+  struct cpustat cs[NCPU];
+  int fd, i, n, reader, high, hogs[NCPU], pfds[2], old, start, done;
+  char *big;
+
+  printf(1, "priority inheritance test\n");
+
+  fd = open("pifile", O_CREATE|O_RDWR);
+  if(fd < 0){
+    printf(1, "priorityinherit: create failed\n");
+    exit();
+  }
+  memset(buf, 'p', BSIZE);
+  for(i = 0; i < PIBLOCKS; i++){
+    if(write(fd, buf, BSIZE) != BSIZE){
+      printf(1, "priorityinherit: write failed\n");
+      exit();
+    }
+  }
+  close(fd);
+
+  old = setscheduler(SCHED_PBS);
+  set_priority(0, getpid());
+
+  reader = fork();
+  if(reader == 0){
+    big = malloc(PIBLOCKS * BSIZE);
+    for(;;){
+      fd = open("pifile", 0);
+      read(fd, big, PIBLOCKS * BSIZE);
+      close(fd);
+    }
+  }
+  set_priority(90, reader);
+  sleep(2);
+
+  n = getcpustat(cs, NCPU);
+  for(i = 0; i < n; i++){
+    hogs[i] = fork();
+    if(hogs[i] == 0)
+      for(;;)
+        ;
+    set_priority(50, hogs[i]);
+  }
+  sleep(5);
+
+  pipe(pfds);
+  start = uptime();
+  high = fork();
+  if(high == 0){
+    close(pfds[0]);
+    fd = open("pifile", 0);
+    close(fd);
+    done = uptime();
+    write(pfds[1], &done, sizeof(done));
+    exit();
+  }
+  close(pfds[1]);
+  set_priority(10, high);
+
+  sleep(PITICKS);
+  for(i = 0; i < n; i++)
+    kill(hogs[i]);
+  kill(reader);
+  if(read(pfds[0], &done, sizeof(done)) != sizeof(done)){
+    printf(1, "priorityinherit: read failed\n");
+    exit();
+  }
+  close(pfds[0]);
+  for(i = 0; i < n + 2; i++)
+    wait();
+  setscheduler(old);
+  set_priority(60, getpid());
+  unlink("pifile");
+
+  if(done - start >= PITICKS){
+    printf(1, "priorityinherit: open waited %d ticks for a starved lock holder\n",
+           done - start);
+    exit();
+  }
+  printf(1, "priority inheritance ok\n");
+}
+
 // try to find any races between exit and wait
 void
 exitwait(void)
@@ -1782,6 +1879,7 @@ main(int argc, char *argv[])
   mem();
   pipe1();
   preempt();
+  priorityinherit();
   exitwait();
 
   rmdot();
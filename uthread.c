@@ -0,0 +1,168 @@
+// User-level thread library, on top of clone(), join() and the
+// futex system calls.
+
+#include "types.h"
+#include "user.h"
+#include "x86.h"
+
+// Spin locks for threads that share memory.
+void
+lock_init(lock_t *lk)
+{
+  lk->locked = 0;
+}
+
+void
+lock_acquire(lock_t *lk)
+{
+  while(xchg(&lk->locked, 1) != 0)
+    ;
+}
+
+void
+lock_release(lock_t *lk)
+{
+  xchg(&lk->locked, 0);
+}
+
+// Threads.  Each thread gets a one-page stack from malloc(), which
+// thread_join() frees again.  malloc() is not thread-safe, so both
+// take a lock around it.
+
+#define TSTACKSIZE 4096
+
+static lock_t tlock;
+
+// Start a thread running fcn(arg1, arg2).  Returns its pid, or -1.
+int
+thread_create(void (*fcn)(void*, void*), void *arg1, void *arg2)
+{
+  void *stack;
+  int pid;
+
+  lock_acquire(&tlock);
+  stack = malloc(TSTACKSIZE);
+  lock_release(&tlock);
+  if(stack == 0)
+    return -1;
+  if((pid = clone(fcn, arg1, arg2, stack)) < 0){
+    lock_acquire(&tlock);
+    free(stack);
+    lock_release(&tlock);
+  }
+  return pid;
+}
+
+// Wait for one of this process's threads to exit, free its stack,
+// and return its pid.  Returns -1 if there are no threads.
+int
+thread_join(void)
+{
+  void *stack;
+  int pid;
+
+  if((pid = join(&stack)) < 0)
+    return -1;
+  lock_acquire(&tlock);
+  free(stack);
+  lock_release(&tlock);
+  return pid;
+}
+
+// Mutexes that sleep in the kernel instead of spinning, after
+// Drepper, "Futexes Are Tricky".  state is 0 if unlocked, 1 if
+// locked, and 2 if locked and some thread may be waiting, so an
+// unlock only makes a system call when it might have to wake one.
+void
+mutex_init(mutex_t *m)
+{
+  m->state = 0;
+}
+
+void
+mutex_lock(mutex_t *m)
+{
+  int c;
+
+  if((c = __sync_val_compare_and_swap(&m->state, 0, 1)) == 0)
+    return;
+  if(c != 2)
+    c = __sync_lock_test_and_set(&m->state, 2);
+  while(c != 0){
+    futex_wait(&m->state, 2);
+    c = __sync_lock_test_and_set(&m->state, 2);
+  }
+}
+
+void
+mutex_unlock(mutex_t *m)
+{
+  if(__sync_fetch_and_sub(&m->state, 1) != 1){
+    m->state = 0;
+    futex_wake(&m->state, 1);
+  }
+}
+
+// Condition variables.  seq changes on every signal, so a waiter
+// that has released the mutex but not yet slept sees the change
+// in futex_wait() and does not sleep.
+void
+cond_init(cond_t *c)
+{
+  c->seq = 0;
+}
+
+void
+cond_wait(cond_t *c, mutex_t *m)
+{
+  int seq = c->seq;
+
+  mutex_unlock(m);
+  futex_wait(&c->seq, seq);
+  mutex_lock(m);
+}
+
+void
+cond_signal(cond_t *c)
+{
+  __sync_fetch_and_add(&c->seq, 1);
+  futex_wake(&c->seq, 1);
+}
+
+void
+cond_broadcast(cond_t *c)
+{
+  __sync_fetch_and_add(&c->seq, 1);
+  futex_wake(&c->seq, -1);
+}
+
+// Barriers: barrier_wait() returns once n threads have called it.
+// gen counts the times the barrier has opened, so the same
+// barrier can be used again straight away.
+void
+barrier_init(barrier_t *b, int n)
+{
+  mutex_init(&b->m);
+  cond_init(&b->c);
+  b->n = n;
+  b->count = 0;
+  b->gen = 0;
+}
+
+void
+barrier_wait(barrier_t *b)
+{
+  int gen;
+
+  mutex_lock(&b->m);
+  gen = b->gen;
+  if(++b->count == b->n){
+    b->count = 0;
+    b->gen++;
+    cond_broadcast(&b->c);
+  } else {
+    while(gen == b->gen)
+      cond_wait(&b->c, &b->m);
+  }
+  mutex_unlock(&b->m);
+}
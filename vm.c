@@ -16,17 +16,30 @@ void
 seginit(void)
 {
   struct cpu *c;
+  int apicid;
+
+  // %gs is not set up yet, so mycpu() cannot be used.  APIC IDs
+  // are not guaranteed to be contiguous, so search for ours.
+  apicid = lapicid();
+  for(c = cpus; c < cpus+ncpu && c->apicid != apicid; c++)
+    ;
+  if(c == cpus+ncpu)
+    panic("seginit: unknown apicid");
 
   // Map "logical" addresses to virtual addresses using identity map.
   // Cannot share a CODE descriptor for both kernel and user
   // because it would have to have DPL_USR, but the CPU forbids
   // an interrupt from CPL=0 to DPL=3.
-  c = &cpus[cpuid()];
   c->gdt[SEG_KCODE] = SEG(STA_X|STA_R, 0, 0xffffffff, 0);
   c->gdt[SEG_KDATA] = SEG(STA_W, 0, 0xffffffff, 0);
   c->gdt[SEG_UCODE] = SEG(STA_X|STA_R, 0, 0xffffffff, DPL_USER);
   c->gdt[SEG_UDATA] = SEG(STA_W, 0, 0xffffffff, DPL_USER);
+
+  // Map %gs to this CPU's struct cpu, for mycpu() and myproc().
+  c->gdt[SEG_KCPU] = SEG(STA_W, c, sizeof(*c) - 1, 0);
+  c->self = c;
   lgdt(c->gdt, sizeof(c->gdt));
+  loadgs(SEG_KCPU << 3);
 }
 
 // Return the address of the PTE in page table pgdir
@@ -0,0 +1,87 @@
+// Wakeup latency under CPU-bound load.
+//
+// wakelat [hogs] [ticks] starts CPU hogs (default two per CPU) at
+// a poor priority, then has a high-priority pair of processes pass
+// a byte back and forth over two pipes for the given number of
+// ticks (default 200), and prints the number of round trips.  Each
+// trip wakes a process, usually on a CPU that is running a hog, so
+// the count shows how soon a woken process gets to run.  Without
+// preemption on wakeup, every wakeup on a busy CPU waits for the
+// hog's tick to end.  Run it under PBS or MLFQ, or as
+// "schedlat wakelat" to see the latencies.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "pstat.h"
+
+#define MAXHOGS  32
+
+struct cpustat cs[NCPU];
+
+int
+main(int argc, char *argv[])
+{
+  int nhogs, nticks, i, trips, echo;
+  int pid[MAXHOGS], ping[2], pong[2];
+  uint start;
+  char c;
+
+  nhogs = argc > 1 ? atoi(argv[1]) : 2 * getcpustat(cs, NCPU);
+  nticks = argc > 2 ? atoi(argv[2]) : 200;
+  if(nhogs < 0 || nhogs > MAXHOGS || nticks <= 0){
+    printf(2, "usage: wakelat [hogs] [ticks]\n");
+    exit();
+  }
+
+  for(i = 0; i < nhogs; i++){
+    if((pid[i] = fork()) < 0){
+      printf(2, "wakelat: fork failed\n");
+      nhogs = i;
+      break;
+    }
+    if(pid[i] == 0)
+      for(;;)
+        ;
+    set_priority(90, pid[i]);
+  }
+
+  if(pipe(ping) < 0 || pipe(pong) < 0){
+    printf(2, "wakelat: pipe failed\n");
+    exit();
+  }
+  if((echo = fork()) < 0){
+    printf(2, "wakelat: fork failed\n");
+    exit();
+  }
+  if(echo == 0){
+    close(ping[1]);
+    close(pong[0]);
+    while(read(ping[0], &c, 1) == 1)
+      write(pong[1], &c, 1);
+    exit();
+  }
+  close(ping[0]);
+  close(pong[1]);
+  set_priority(10, echo);
+  set_priority(10, getpid());
+
+  trips = 0;
+  start = uptime();
+  while(uptime() - start < nticks){
+    write(ping[1], &c, 1);
+    if(read(pong[0], &c, 1) != 1)
+      break;
+    trips++;
+  }
+  close(ping[1]);
+  wait();
+
+  printf(1, "%d hogs: %d round trips in %d ticks\n", nhogs, trips, nticks);
+  for(i = 0; i < nhogs; i++){
+    kill(pid[i]);
+    wait();
+  }
+  exit();
+}
@@ -0,0 +1,36 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+// Run a command and report how many wakeups it caused and how many
+// sleeping processes those wakeups had to look at.
+int 
+main(int argc, char **argv)
+{
+    int w0, s0, w1, s1, rc;
+
+    if (argc < 2)
+    {
+        printf(2, "Usage: wakeups <command> [args...]\n");
+        exit();
+    }
+
+    wakestat(&w0, &s0);
+    rc = fork();
+    if (rc < 0)
+        printf(2, "fork error: fork failed!\n");
+    else if (rc == 0)
+    { 
+        exec(argv[1], argv + 1);
+        printf(2, "exec error: exec failed!\n");
+        exit();
+    }
+    wait();
+    wakestat(&w1, &s1);
+
+    w1 -= w0;
+    s1 -= s0;
+    printf(1, "wakeups: %d, processes scanned: %d, per wakeup: %d\n",
+           w1, s1, w1 > 0 ? s1 / w1 : 0);
+    exit();
+}
@@ -117,6 +117,40 @@ sti(void)
   asm volatile("sti");
 }
 
+// Read the time stamp counter: CPU cycles since reset.
+static inline uint64
+rdtsc(void)
+{
+  uint64 t;
+
+  asm volatile("rdtsc" : "=A" (t));
+  return t;
+}
+
+// Divide n by d.  The kernel is not linked with libgcc, which
+// C's 64-bit division would call, so divide the high word first
+// and then the remainder and low word together with divl.  The
+// remainder is less than d, so the second quotient fits in 32 bits.
+static inline uint64
+divu64(uint64 n, uint d)
+{
+  uint hi = n >> 32, lo = n, qhi, qlo, r;
+
+  qhi = hi / d;
+  r = hi % d;
+  asm("divl %4" : "=a" (qlo), "=d" (r) : "a" (lo), "d" (r), "rm" (d));
+  return ((uint64)qhi << 32) | qlo;
+}
+
+// Enable interrupts and halt until the next one arrives.  sti
+// takes effect only after the instruction that follows it, so an
+// interrupt cannot slip in between and leave the CPU halted.
+static inline void
+stihlt(void)
+{
+  asm volatile("sti; hlt");
+}
+
 static inline uint
 xchg(volatile uint *addr, uint newval)
 {